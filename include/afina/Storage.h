@@ -1,7 +1,13 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
@@ -10,6 +16,39 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * What Update should do with the key once updater function is done
+     */
+    enum class UpdateAction { Keep, Store, Remove };
+
+    /**
+     * Updater function gets current value, or nullptr if key isn't present, and writes new value into
+     * the second argument if it decides to store one
+     */
+    using Updater = std::function<UpdateAction(const std::string *current, std::string &updated)>;
+
+    /**
+     * Tells if value found for the key counts as present, e.g. it isn't expired yet. Value that doesn't is
+     * treated the same way as missing key
+     */
+    using Check = std::function<bool(const std::string &current)>;
+
+    /**
+     * Gets value found for the key right before data is added to it and could rewrite it in place, e.g. to change
+     * header. Returns false, leaving value intact, if it doesn't count as present
+     */
+    using Patch = std::function<bool(std::string &current)>;
+
+    /**
+     * Gets items passed by Scan
+     */
+    using Visitor = std::function<void(std::string_view key, std::string_view value)>;
+
+    /**
+     * Gets key removed by the storage itself to free space for other items
+     */
+    using Evicted = std::function<void(const std::string &key)>;
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -84,6 +123,229 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Atomic read-modify-write of the value for the given key
+     * Calls updater with current value and then stores value it produced or
+     * removes the key, depending on what updater returns. No other operation
+     * on the same key could happen in between.
+     *
+     * Default implementation is built on top of Get/Put/Delete, so it isn't
+     * atomic. Thread safe storages must override it.
+     *
+     * Method returns true if value has been stored or key has been removed,
+     * false if updater decided to keep things as is or store failed
+     *
+     * @param key to update value for
+     * @param update function deciding what to do with the key
+     */
+    virtual bool Update(const std::string &key, const Updater &update) {
+        std::string current, updated;
+        bool found = Get(key, current);
+        switch (update(found ? &current : nullptr, updated)) {
+        case UpdateAction::Store:
+            return Put(key, updated);
+        case UpdateAction::Remove:
+            return Delete(key);
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * Conditional writes below do existence check and mutation in one index lookup under one lock, so nobody
+     * could change the key in between. Default implementations are built on top of Update, storages override
+     * them to avoid copying values through updater
+     */
+
+    /**
+     * Stores value only if key is absent or its value doesn't pass the check
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param present tells if value found for the key is still there
+     */
+    virtual bool Add(const std::string &key, const std::string &value, const Check &present) {
+        return Update(key, [&](const std::string *current, std::string &updated) {
+            if (current != nullptr && present(*current)) {
+                return UpdateAction::Keep;
+            }
+            updated = value;
+            return UpdateAction::Store;
+        });
+    }
+
+    /**
+     * Stores value only if key is present and its value passes the check
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param present tells if value found for the key is still there
+     */
+    virtual bool Replace(const std::string &key, const std::string &value, const Check &present) {
+        return Update(key, [&](const std::string *current, std::string &updated) {
+            if (current == nullptr || !present(*current)) {
+                return UpdateAction::Keep;
+            }
+            updated = value;
+            return UpdateAction::Store;
+        });
+    }
+
+    /**
+     * Inserts data into the existing value after its first offset bytes if patch accepts it, so that value could
+     * keep its header in front. Offset past the end of value means append
+     *
+     * @param key to add data for
+     * @param data to be inserted
+     * @param offset position in the value to insert data at
+     * @param patch called on the current value before data is added
+     */
+    virtual bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) {
+        return Update(key, [&](const std::string *current, std::string &updated) {
+            if (current == nullptr) {
+                return UpdateAction::Keep;
+            }
+            updated.reserve(current->size() + data.size());
+            updated = *current;
+            if (!patch(updated)) {
+                return UpdateAction::Keep;
+            }
+            updated.insert(std::min(offset, updated.size()), data);
+            return UpdateAction::Store;
+        });
+    }
+
+    /**
+     * Adds data to the end of the existing value if patch accepts it
+     *
+     * @param key to add data for
+     * @param data to be appended
+     * @param patch called on the current value before data is added
+     */
+    bool Append(const std::string &key, const std::string &data, const Patch &patch) {
+        return Insert(key, data, std::string::npos, patch);
+    }
+
+    /**
+     * Adds data to the beginning of the existing value if patch accepts it. Values with header use Insert to keep
+     * header in front
+     *
+     * @param key to add data for
+     * @param data to be prepended
+     * @param patch called on the current value before data is added
+     */
+    bool Prepend(const std::string &key, const std::string &data, const Patch &patch) {
+        return Insert(key, data, 0, patch);
+    }
+
+    /**
+     * Reads values for the batch of keys, results are in the request order: found[i] tells if keys[i] is
+     * present and values[i] is its value then. Vectors are resized to the number of keys, so caller could
+     * reuse them between calls without allocations
+     *
+     * Default implementation calls Get for each key. Thread safe storages should override it to take
+     * lock once per batch rather than once per key
+     *
+     * @param keys to read values for
+     * @param values output parameter for the values
+     * @param found output parameter telling which keys are present
+     */
+    virtual void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                          std::vector<bool> &found) {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+
+        std::string key;
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            key.assign(keys[i]);
+            found[i] = Get(key, values[i]);
+        }
+    }
+
+    /**
+     * Returns version of the key, which changes once any write to the key is done, so that caches outside of the
+     * storage could tell if value they have read before is still the same. Version must be taken before value is
+     * read. Storage could start to track versions of the key only on the first call, so writes to keys nobody
+     * caches stay cheap.
+     *
+     * Versions of different keys could be shared, so write to one key could change version of another one.
+     * Default implementation returns 0, which means that storage doesn't track versions and values read from it
+     * must not be cached
+     *
+     * @param key to get version of
+     */
+    virtual uint64_t Version(std::string_view key) { return 0; }
+
+    /**
+     * Makes storage call function for each key it evicts, so that caches outside of the storage could drop their
+     * copies of the key. Function is called under storage locks before the write that needed space returns, so it
+     * must be short and must not call storage. Must be called before storage is shared between threads.
+     *
+     * Method returns false if storage doesn't report evictions, default implementation does so
+     *
+     * @param evicted function to call for each evicted key
+     */
+    virtual bool OnEvict(const Evicted &evicted) { return false; }
+
+    /**
+     * Counts read of the key served by a cache outside of the storage, so that key stays recently used and admission
+     * policy keeps counting its reads. Caches call it for a sample of their hits only.
+     *
+     * Default implementation reads the value
+     *
+     * @param key that has been read
+     */
+    virtual void Touch(const std::string &key) {
+        std::string value;
+        Get(key, value);
+    }
+
+    /**
+     * Runs function while storage can't change: all its locks are held, so that process could be forked and
+     * storage scanned in the child. Function must not call storage. Requests of other threads wait until function
+     * returns, so it must be short.
+     *
+     * Default implementation just calls function, which is right for storages that aren't thread safe
+     *
+     * @param frozen function to run
+     */
+    virtual void Freeze(const std::function<void()> &frozen) { frozen(); }
+
+    /**
+     * Passes all items to the visitor without taking any locks, from the least recently used to the most recently
+     * used one as far as storage tracks recency, so that storing them in the same order restores it. Must be
+     * called only when nobody could change storage: by the only thread using storage that isn't thread safe or in
+     * the child process forked inside Freeze.
+     *
+     * Method returns false if storage doesn't support scan
+     *
+     * @param visit function to call for each item
+     */
+    virtual bool Scan(const Visitor &visit) { return false; }
+
+    /**
+     * Returns number of independent partitions of the storage. Writes of keys from different partitions don't
+     * affect each other, e.g. one never evicts the other, so they could go concurrently and recency order of each
+     * partition depends only on the order of its own writes
+     */
+    virtual std::size_t Partitions() { return 1; }
+
+    /**
+     * Returns partition the key belongs to, in [0, Partitions())
+     */
+    virtual std::size_t Partition(std::string_view key) { return 0; }
+
+    /**
+     * Appends storage specific statistics as name/value pairs to the given list, it is
+     * reported to clients by the "stats" command.
+     *
+     * Method could be called concurrently with any other one, so implementation must
+     * be thread safe if storage is
+     *
+     * @param stats output parameter to append statistics to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
 };
 
 } // namespace Afina
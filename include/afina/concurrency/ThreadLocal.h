@@ -1,10 +1,97 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <pthread.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per object thread local storage
+ * Unlike thread_local keyword gives each thread its own instance of T per ThreadLocal object, so that
+ * several storages could each keep private per-thread state.
+ *
+ * All instances are owned by ThreadLocal object and could be visited from any thread using for_each, which
+ * allows to aggregate or drain per-thread data. Slot of exited thread gets reused by the next new thread, so
+ * number of instances is bounded by the maximum number of threads ever alive at once.
+ *
+ * Visitor must be synchronized with owner threads by the caller: ThreadLocal only protects list of slots
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() {
+        if (pthread_key_create(&_key, &ThreadLocal::release) != 0) {
+            throw std::runtime_error("Failed to create thread local key");
+        }
+    }
+
+    ~ThreadLocal() { pthread_key_delete(_key); }
+
+    /**
+     * Returns instance that belongs to the calling thread, creates one on the first access
+     */
+    T &get() {
+        slot *s = static_cast<slot *>(pthread_getspecific(_key));
+        if (s == nullptr) {
+            s = acquire();
+            pthread_setspecific(_key, s);
+        }
+        return s->value;
+    }
+
+    /**
+     * Calls f for each instance ever created, including ones of already stopped threads
+     */
+    template <typename F> void for_each(F &&f) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (auto &s : _slots) {
+            f(s->value);
+        }
+    }
+
+private:
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    struct slot {
+        ThreadLocal *owner;
+        bool used;
+        T value;
+
+        slot(ThreadLocal *o) : owner(o), used(true), value() {}
+    };
+
+    slot *acquire() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (auto &s : _slots) {
+            if (!s->used) {
+                s->used = true;
+                return s.get();
+            }
+        }
+
+        _slots.emplace_back(new slot(this));
+        return _slots.back().get();
+    }
+
+    // Called by pthread on thread exit
+    static void release(void *p) {
+        slot *s = static_cast<slot *>(p);
+        std::unique_lock<std::mutex> lock(s->owner->_mutex);
+        s->used = false;
+    }
+
+    pthread_key_t _key;
+
+    // Protects list of slots, but not slots content
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<slot>> _slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,61 @@
+#ifndef AFINA_EXECUTE_ARITHMETIC_H
+#define AFINA_EXECUTE_ARITHMETIC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Increment or decrement counter
+ * incr <key> <value>
+ * decr <key> <value>
+ *
+ * Item data must be decimal representation of 64-bit unsigned integer. Value is changed in place under the
+ * storage lock, so concurrent clients never lose updates. Increment wraps around, decrement stops at 0. Item gets
+ * new CAS unique, its flags and expiration time are kept.
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the item
+ * - "NOT_FOUND" to indicate the item with this key was not found
+ * - "CLIENT_ERROR ..." if item data isn't a number
+ */
+class Arithmetic : public Command {
+public:
+    Arithmetic() : _delta(0), _decrement(false) {}
+    Arithmetic(const std::string &key, uint64_t delta, bool decrement)
+        : _key(key), _delta(delta), _decrement(decrement) {}
+    ~Arithmetic() {}
+
+    inline const std::string &key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+    inline bool decrement() const { return _decrement; }
+
+    /**
+     * Reinitializes command for the next request, so that the same object could be reused without allocations
+     */
+    inline void Assign(std::string_view key, uint64_t delta, bool decrement) {
+        _key.assign(key);
+        _delta = delta;
+        _decrement = decrement;
+    }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
+    uint64_t _delta;
+    bool _decrement;
+
+    // Buffer for the new value, reused between requests
+    std::string _value;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_ARITHMETIC_H
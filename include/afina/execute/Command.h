@@ -9,6 +9,8 @@ class Storage;
 
 namespace Execute {
 
+class Response;
+
 /**
  *
  *
@@ -19,6 +21,16 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Executes command appending its response to the builder, so that response could be sent without extra
+     * copies. By default text written by the Execute above is copied into the builder
+     */
+    virtual void Execute(Storage &storage, const std::string &args, Response &out);
+
+protected:
+    // Response text of the default implementation above, reused between requests
+    std::string _text;
 };
 
 } // namespace Execute
@@ -0,0 +1,80 @@
+#ifndef AFINA_EXECUTE_COUNTERS_H
+#define AFINA_EXECUTE_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Server counters
+ * Each thread updates its own cache line sized slot of counters: no locked instructions and no cache line
+ * ping-pong on the request path. Slots are summed up only when somebody asks for statistics, counters of exited
+ * threads are folded into the common total.
+ *
+ * Counters are signed, so that gauges like the number of connections could be incremented by one thread and
+ * decremented by another one
+ */
+class Counters {
+public:
+    enum Counter : uint8_t {
+        cmdGet,
+        cmdSet,
+        getHits,
+        getMisses,
+        currConnections,
+        totalConnections,
+        nearCacheHits,
+        Count
+    };
+
+    struct alignas(64) Slot {
+        // Written only by the owner thread, so plain load and store are enough, no read-modify-write
+        std::atomic<int64_t> values[Count];
+
+        Slot() {
+            for (auto &v : values) {
+                v.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * Adds delta to the counter in the slot of the calling thread
+     */
+    static inline void Add(Counter counter, int64_t delta = 1) {
+        std::atomic<int64_t> &value = Local().values[counter];
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    /**
+     * Sums counters of all threads into totals, which must have Count elements
+     *
+     * @param totals output parameter for the counter values
+     * @return number of threads which have counter slots now
+     */
+    static std::size_t Collect(int64_t *totals);
+
+    static const char *Name(Counter counter);
+
+private:
+    // Returns slot of the calling thread, registers one on the first call
+    static inline Slot &Local() {
+        if (__builtin_expect(_local == nullptr, 0)) {
+            _local = &attach();
+        }
+        return *_local;
+    }
+
+    // Registers slot for the calling thread, it is released on thread exit
+    static Slot &attach();
+
+    static thread_local Slot *_local;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_COUNTERS_H
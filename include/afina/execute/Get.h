@@ -2,9 +2,12 @@
 #define AFINA_EXECUTE_GET_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Command.h"
+#include "NearCache.h"
+#include "Response.h"
 
 namespace Afina {
 namespace Execute {
@@ -24,25 +27,55 @@ namespace Execute {
  * END
  *
  * Where <key> is the key for the value, <bytes> is the number of bytes in the
- * value and <data> is the value text
+ * value and <data> is the value text. "gets" adds item CAS unique after <bytes>,
+ * it is to be passed to the "cas" command
  *
  * If some of the keys appearing in a retrieval request are not sent back
  * by the server in the item list this means that the server does not
  * hold items with such keys (because they were never stored, or stored
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
+ *
+ * Keys are views, memory they point to must outlive the command. If network worker passes its near cache then
+ * get serves hot keys from there and caches them, gets always reads storage
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get() : _with_cas(false), _near(nullptr) {}
+    Get(const std::vector<std::string_view> &keys, bool with_cas = false, NearCache *near = nullptr)
+        : _keys(keys), _with_cas(with_cas), _near(near) {}
     ~Get() {}
 
-    inline const std::vector<std::string> &keys() const { return _keys; }
+    inline const std::vector<std::string_view> &keys() const { return _keys; }
+    inline bool with_cas() const { return _with_cas; }
+
+    /**
+     * Reinitializes command for the next request, so that the same object could be reused without allocations
+     */
+    inline void Assign(const std::vector<std::string_view> &keys, bool with_cas = false, NearCache *near = nullptr) {
+        _keys.assign(keys.begin(), keys.end());
+        _with_cas = with_cas;
+        _near = near;
+    }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Value bodies are referenced from the command buffers, so response is valid until next Execute
+    void Execute(Storage &storage, const std::string &args, Response &out) override;
+
 private:
-    std::vector<std::string> _keys;
+    std::vector<std::string_view> _keys;
+    bool _with_cas;
+    NearCache *_near;
+
+    // Buffers reused by Execute calls. Values and found are for the keys read from storage, which are all the keys
+    // unless there is near cache
+    std::vector<std::string> _values;
+    std::vector<bool> _found;
+    std::vector<const std::string *> _cached;
+    std::vector<std::string_view> _misses;
+    std::vector<uint64_t> _versions;
+    Response _response;
 };
 
 } // namespace Execute
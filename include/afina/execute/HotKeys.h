@@ -0,0 +1,79 @@
+#ifndef AFINA_EXECUTE_HOT_KEYS_H
+#define AFINA_EXECUTE_HOT_KEYS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Hot keys detection
+ * Keys accessed by get and store commands are sampled, roughly one out of Sampling() accesses, into the space-saving
+ * top-K sketch of the calling thread. Sketch keeps Capacity most frequent keys with their estimated number of
+ * accesses: new key takes place of the least frequent one and inherits its count as an error bound, so any key which
+ * takes more than 1/Capacity of sampled accesses is guaranteed to be reported.
+ *
+ * Accesses that aren't sampled cost a thread local decrement. Sketches of all threads are merged only when someone
+ * asks for the top. Counts of each sketch are halved every DecayPeriod samples, so that keys which are no longer
+ * hot fade away and report follows the current load
+ */
+class HotKeys {
+public:
+    // Number of keys tracked by each thread
+    static constexpr std::size_t Capacity = 64;
+
+    static constexpr uint64_t DecayPeriod = 1 << 14;
+
+    struct Entry {
+        std::string key;
+
+        // Estimated number of accesses, never less than the real one since the last decay
+        uint64_t count;
+
+        // Maximum overestimation of the count
+        uint64_t error;
+    };
+
+    /**
+     * Returns mean number of accesses per sample, 0 means that detection is off
+     */
+    static inline uint32_t Sampling() { return _sampling.load(std::memory_order_relaxed); }
+
+    static inline void SetSampling(uint32_t sampling) { _sampling.store(sampling, std::memory_order_relaxed); }
+
+    /**
+     * Counts access to the key if it gets sampled
+     */
+    static inline void Record(std::string_view key) {
+        if (Sampling() != 0 && __builtin_expect(--_countdown <= 0, 0)) {
+            record(key);
+        }
+    }
+
+    /**
+     * Merges sketches of all threads and returns at most limit keys with the biggest counts, in descending order
+     *
+     * @param limit maximum number of keys to return
+     * @param top output parameter for the keys
+     */
+    static void Collect(std::size_t limit, std::vector<Entry> &top);
+
+private:
+    // Puts key into the sketch of the calling thread and chooses distance to the next sample
+    static void record(std::string_view key);
+
+    static std::atomic<uint32_t> _sampling;
+
+    // Accesses left until the next sample, up to twice the sampling so it doesn't fit 32 bits
+    static thread_local int64_t _countdown;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_HOT_KEYS_H
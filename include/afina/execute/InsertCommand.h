@@ -3,8 +3,10 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "Command.h"
+#include "Item.h"
 
 namespace Afina {
 namespace Execute {
@@ -15,6 +17,7 @@ namespace Execute {
  */
 class InsertCommand : public Command {
 public:
+    InsertCommand() : _flags(0), _expire(0) {}
     InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
     ~InsertCommand() {}
 
@@ -22,10 +25,31 @@ public:
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Reinitializes command for the next request, so that the same object could be reused without allocations
+     */
+    inline void Assign(std::string_view key, uint32_t flags, int32_t expire) {
+        _key.assign(key);
+        _flags = flags;
+        _expire = expire;
+    }
+
 protected:
-    const std::string _key;
-    const uint32_t _flags;
-    const int32_t _expire;
+    // Encodes data as new item with command flags and expiration time
+    inline void encode(std::string_view data, std::string &stored) const {
+        Item item;
+        item.flags = _flags;
+        item.exptime = Item::ExpireAt(_expire, Item::Now());
+        item.cas = Item::NextCas();
+        Item::Encode(item, data, stored);
+    }
+
+    std::string _key;
+    uint32_t _flags;
+    int32_t _expire;
+
+    // Buffer for the value to be stored, reused between requests
+    std::string _stored;
 };
 
 } // namespace Execute
@@ -0,0 +1,101 @@
+#ifndef AFINA_EXECUTE_ITEM_H
+#define AFINA_EXECUTE_ITEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Item metadata
+ * Storage keeps values opaque, so commands put item metadata into the fixed size header in front of the data:
+ * client flags, expiration time, CAS unique and meta protocol state.
+ *
+ * All commands must store values through Encode and read them through Decode, so that every protocol sees the
+ * same flags, expiration and CAS.
+ */
+struct Item {
+    enum State : uint8_t {
+        // Item is invalidated, but still could be served while somebody recaches it
+        sStale = 1,
+
+        // Some client has got the right to recache the item already
+        sWinSent = 2
+    };
+
+    // Number of bytes header takes in the stored value
+    static constexpr std::size_t HeaderSize = 24;
+
+    uint32_t flags = 0;
+    uint8_t state = 0;
+
+    // Absolute unix time item expires at, 0 if it never expires
+    int64_t exptime = 0;
+
+    uint64_t cas = 0;
+
+    /**
+     * Parses stored value. Returns false if value wasn't stored by Encode
+     */
+    static bool Decode(const std::string &stored, Item &item, std::string_view &data);
+
+    /**
+     * Parses stored value that could be absent. Returns true only if item is there and isn't expired yet
+     */
+    static inline bool Live(const std::string *stored, int64_t now, Item &item, std::string_view &data) {
+        return stored != nullptr && Decode(*stored, item, data) && !item.Expired(now);
+    }
+
+    /**
+     * Tells if stored value is there and isn't expired yet, for storage conditional writes
+     */
+    static inline bool Live(const std::string &stored, int64_t now) {
+        Item item;
+        std::string_view data;
+        return Live(&stored, now, item, data);
+    }
+
+    /**
+     * Writes header followed by data into stored
+     */
+    static void Encode(const Item &item, std::string_view data, std::string &stored);
+
+    /**
+     * Rewrites CAS unique in the header of the stored value in place
+     */
+    static void SetCas(std::string &stored, uint64_t cas);
+
+    /**
+     * Converts memcached exptime into absolute time: values up to 30 days are offsets from now, bigger ones are
+     * unix time, negative means already expired and 0 never expires
+     */
+    static int64_t ExpireAt(int64_t exptime, int64_t now);
+
+    /**
+     * Returns new CAS unique, never 0
+     */
+    static uint64_t NextCas();
+
+    /**
+     * Parses value of the counter used by incr/decr: decimal 64-bit unsigned number, digits only
+     */
+    static bool Counter(std::string_view data, uint64_t &value);
+
+    /**
+     * Returns current unix time
+     */
+    static int64_t Now();
+
+    inline bool Expired(int64_t now) const { return exptime != 0 && exptime <= now; }
+
+    // Seconds left to live or -1 if item never expires
+    inline int64_t TTL(int64_t now) const { return exptime == 0 ? -1 : (exptime > now ? exptime - now : 0); }
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_ITEM_H
@@ -0,0 +1,119 @@
+#ifndef AFINA_EXECUTE_LATENCY_H
+#define AFINA_EXECUTE_LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command latency histograms
+ * Latencies are recorded per command type and per phase of request processing into log-linear histograms, like
+ * HDR histogram does: each power of two range is split onto 8 equal buckets, so any value is reported with at
+ * most 12.5% error, from nanoseconds up to minutes in a few kilobytes.
+ *
+ * Each thread records into its own set of histograms, recording is a bucket index computation and a single
+ * counter increment without locked instructions. Histograms of all threads are merged only when someone asks
+ * for percentiles.
+ */
+class Latency {
+public:
+    enum Op : uint8_t {
+        opGet,
+        opSet,
+        opAdd,
+        opReplace,
+        opAppend,
+        opPrepend,
+        opCas,
+        opIncr,
+        opDecr,
+        opDelete,
+        opMeta,
+        opOther,
+        OpCount
+    };
+
+    enum Phase : uint8_t { phParse, phStorage, phWrite, PhaseCount };
+
+    // Values under 2^SubBits are exact, each next power of two range has 2^SubBits buckets
+    static constexpr unsigned SubBits = 3;
+    static constexpr uint64_t SubBuckets = 1 << SubBits;
+
+    // Anything longer than 2^MaxBits nanoseconds, about 18 minutes, goes to the last bucket
+    static constexpr unsigned MaxBits = 40;
+    static constexpr std::size_t Buckets = (MaxBits - SubBits + 1) * SubBuckets;
+
+    /**
+     * Merged histogram of all threads
+     */
+    struct Snapshot {
+        uint64_t counts[Buckets];
+        uint64_t total;
+        uint64_t max;
+
+        /**
+         * Returns value which is greater or equal than given fraction of recorded values, up to bucket precision
+         */
+        uint64_t Percentile(double fraction) const;
+    };
+
+    static inline uint64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static constexpr std::size_t Bucket(uint64_t value) {
+        if (value < SubBuckets) {
+            return value;
+        } else if (value >= (uint64_t(1) << MaxBits)) {
+            return Buckets - 1;
+        }
+
+        unsigned shift = 63 - __builtin_clzll(value) - SubBits;
+        return (shift + 1) * SubBuckets + ((value >> shift) & (SubBuckets - 1));
+    }
+
+    // Biggest value that falls into the bucket
+    static constexpr uint64_t BucketLimit(std::size_t bucket) {
+        if (bucket < SubBuckets) {
+            return bucket;
+        }
+
+        unsigned shift = bucket / SubBuckets - 1;
+        return ((SubBuckets + bucket % SubBuckets + 1) << shift) - 1;
+    }
+
+    /**
+     * Records duration of the command phase into histogram of the calling thread
+     *
+     * @param op command type
+     * @param phase of the command processing
+     * @param nanoseconds phase took
+     */
+    static void Record(Op op, Phase phase, uint64_t nanoseconds);
+
+    /**
+     * Merges histograms of all threads for the given command type and phase
+     */
+    static void Collect(Op op, Phase phase, Snapshot &snapshot);
+
+    /**
+     * Returns command type for the text protocol command name
+     */
+    static Op OpOf(std::string_view name);
+
+    static const char *Name(Op op);
+
+    static const char *Name(Phase phase);
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_LATENCY_H
@@ -0,0 +1,42 @@
+#ifndef AFINA_EXECUTE_META_ARITHMETIC_H
+#define AFINA_EXECUTE_META_ARITHMETIC_H
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta arithmetic
+ * ma <key> <flag>*
+ *
+ * Increments or decrements value, which must be decimal 64-bit unsigned number. Increment wraps around, decrement
+ * stops at 0. Flags are:
+ * - M<mode>: I or + for increment (the default one), D or - for decrement
+ * - D<delta>: number to add or subtract, 1 by default
+ * - N<ttl>: on miss create item with the given TTL and J value
+ * - J<initial>: initial value for N, 0 by default
+ * - T<ttl>: update item TTL
+ * - C<cas>: update only if item CAS is the same
+ * - q: don't report success
+ * - v: return new value, response is "VA <size> <flags>\r\n<number>" instead of "HD <flags>"
+ * - c, t, k, O: return cas, TTL, key and opaque token
+ *
+ * Command must write result to the output, which could be:
+ * - "HD" or "VA" to indicate success
+ * - "NF" if item is not there
+ * - "EX" if item CAS doesn't match given one
+ * - "CLIENT_ERROR ..." if value isn't a number
+ */
+class MetaArithmetic : public MetaCommand {
+public:
+    MetaArithmetic() {}
+    ~MetaArithmetic() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_ARITHMETIC_H
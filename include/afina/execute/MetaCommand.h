@@ -0,0 +1,73 @@
+#ifndef AFINA_EXECUTE_META_COMMAND_H
+#define AFINA_EXECUTE_META_COMMAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.h"
+#include "Item.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Basic class for all meta commands
+ * Meta command line is: <cmd> <key> <positional args>* <flag>*
+ *
+ * Each flag is a single character, optionally followed by the token: "v", "T30", "Oabc". Response code is followed
+ * by return flags, in the same order client has asked for them, for example "HD c42 t-1 Oabc"
+ *
+ * Command copies key and flags, so the input could be reused as soon as Assign returns
+ */
+class MetaCommand : public Command {
+public:
+    MetaCommand() {}
+    ~MetaCommand() {}
+
+    inline const std::string &key() const { return _key; }
+
+    /**
+     * Reinitializes command for the next request, so that the same object could be reused without allocations
+     *
+     * @param tokens command line tokens following the command name, key is the first one
+     * @param skip number of tokens before the first flag
+     */
+    void Assign(const std::vector<std::string_view> &tokens, std::size_t skip = 1);
+
+protected:
+    // Returns true if client has set the flag, arg is the token following flag character
+    bool flag(char f, std::string_view &arg) const;
+
+    inline bool flag(char f) const {
+        std::string_view arg;
+        return flag(f, arg);
+    }
+
+    // Returns true if client has set the flag with valid numeric token
+    bool number_flag(char f, int64_t &value) const;
+
+    // Returns true if there must be no success response, "q" flag
+    inline bool quiet() const { return flag('q'); }
+
+    /**
+     * Appends return flags requested by client: c(cas), f(flags), s(size), t(ttl), k(key) and O(opaque). Item
+     * related ones are skipped if item is nullptr
+     */
+    void return_flags(std::string &out, const Item *item, std::size_t size, int64_t now) const;
+
+    std::string _key;
+
+    // Flag tokens, each one is followed by space
+    std::string _flags;
+
+    // Buffer for the stored value, reused between requests
+    std::string _value;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_COMMAND_H
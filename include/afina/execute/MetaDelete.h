@@ -0,0 +1,37 @@
+#ifndef AFINA_EXECUTE_META_DELETE_H
+#define AFINA_EXECUTE_META_DELETE_H
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta delete
+ * md <key> <flag>*
+ *
+ * Flags are:
+ * - C<cas>: delete only if item CAS is the same
+ * - I: don't remove item but mark it as stale, so that mg clients keep getting old value while one of them
+ *   recaches it
+ * - T<ttl>: with I, update item TTL
+ * - q: don't report success and miss
+ * - k, O: return key and opaque token
+ *
+ * Command must write result to the output, which could be:
+ * - "HD" to indicate success
+ * - "NF" if item is not there
+ * - "EX" if item CAS doesn't match given one
+ */
+class MetaDelete : public MetaCommand {
+public:
+    MetaDelete() {}
+    ~MetaDelete() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_DELETE_H
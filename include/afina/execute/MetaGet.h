@@ -0,0 +1,38 @@
+#ifndef AFINA_EXECUTE_META_GET_H
+#define AFINA_EXECUTE_META_GET_H
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta get
+ * mg <key> <flag>*
+ *
+ * Returns only what client asked for, so probe for existence is just "HD". Flags are:
+ * - v: return value, response is "VA <size> <flags>\r\n<data>" instead of "HD <flags>"
+ * - c, f, s, t, k, O: return cas, client flags, value size, TTL, key and opaque token
+ * - q: don't report miss
+ * - T<ttl>: update item TTL
+ * - N<ttl>: on miss create empty item with the given TTL, client gets win flag and must recache it
+ * - R<ttl>: win for recache if item TTL is less than given one
+ *
+ * Response flags W, X, Z are added after requested ones: W means client has got the right to recache item, X that
+ * item is stale, Z that win flag has been sent to somebody else already. Only one client wins, others keep serving
+ * stale value until it is recached, so there is no thundering herd of refills on the backend
+ *
+ * Miss is reported as "EN"
+ */
+class MetaGet : public MetaCommand {
+public:
+    MetaGet() {}
+    ~MetaGet() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_GET_H
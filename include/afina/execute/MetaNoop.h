@@ -0,0 +1,27 @@
+#ifndef AFINA_EXECUTE_META_NOOP_H
+#define AFINA_EXECUTE_META_NOOP_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta no-op
+ * Always replies "MN", so client that has pipelined batch of quiet meta commands could find out where the batch
+ * responses end
+ */
+class MetaNoop : public Command {
+public:
+    MetaNoop() {}
+    ~MetaNoop() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_NOOP_H
@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_META_SET_H
+#define AFINA_EXECUTE_META_SET_H
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta set
+ * ms <key> <datalen> <flag>*\r\n
+ * <data block>\r\n
+ *
+ * Flags are:
+ * - F<flags>: client flags to store
+ * - T<ttl>: item TTL, 0 by default
+ * - C<cas>: store only if item CAS is the same
+ * - I: with C, if given CAS is older than item one, then store the value but mark it as stale
+ * - M<mode>: E(add), A(append), P(prepend), R(replace), S(set, the default one)
+ * - q: don't report success
+ * - c, k, O: return new cas, key and opaque token
+ *
+ * Command must write result to the output, which could be:
+ * - "HD" to indicate success
+ * - "NS" if item wasn't stored because of the mode
+ * - "EX" if item CAS doesn't match given one
+ * - "NF" if item to compare CAS with is not there
+ * - "CLIENT_ERROR invalid mode" if mode is unknown
+ */
+class MetaSet : public MetaCommand {
+public:
+    MetaSet() {}
+    ~MetaSet() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_SET_H
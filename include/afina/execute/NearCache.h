@@ -0,0 +1,99 @@
+#ifndef AFINA_EXECUTE_NEAR_CACHE_H
+#define AFINA_EXECUTE_NEAR_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Afina {
+class Storage;
+
+namespace Execute {
+
+struct Item;
+
+/**
+ * # Near cache of get responses
+ * Small direct mapped cache owned by a single network worker thread. It keeps ready to send "VALUE" line and data
+ * block of the keys worker reads most often, so get of such key skips storage locks and response encoding.
+ *
+ * Key is cached once worker has read it HotReads times, read counts are halved every DecayPeriod reads. Entry is
+ * valid while storage reports the same key version as before value was read from it, see Storage::Version, and
+ * while item isn't expired. Storage changes version on eviction as well, so evicted key isn't served. Keys of
+ * storages which don't track versions are never cached.
+ *
+ * Storage doesn't see reads served by the cache, so one out of TouchPeriod hits of the entry is passed to
+ * Storage::Touch to keep the key from being evicted as unused one
+ *
+ * Not thread safe, each worker must have its own
+ */
+class NearCache {
+public:
+    static constexpr uint8_t HotReads = 4;
+    static constexpr uint32_t DecayPeriod = 1 << 13;
+
+    // Bigger values aren't cached
+    static constexpr std::size_t MaxValueSize = 4096;
+
+    // Hits of the entry passed to the storage as a touch
+    static constexpr uint32_t TouchPeriod = 64;
+
+    /**
+     * @param capacity number of cached keys
+     */
+    NearCache(std::size_t capacity);
+    ~NearCache() {}
+
+    inline std::size_t capacity() const { return _entries.size(); }
+
+    /**
+     * Returns cached response for the key or nullptr if there is no valid one. Response is valid until next Store
+     *
+     * @param storage cached values are read from
+     * @param key to find response for
+     * @param now current time, as Item::Now returns
+     */
+    const std::string *Find(Storage &storage, std::string_view key, int64_t now);
+
+    /**
+     * Counts read of the key which missed the cache. Returns version to be passed to Store once value is read from
+     * storage, or 0 if key isn't hot enough to be cached
+     */
+    uint64_t Admit(Storage &storage, std::string_view key);
+
+    /**
+     * Keeps encoded response for the key read from storage
+     *
+     * @param key value has been read for
+     * @param version Admit has returned before value was read
+     * @param item header of the value
+     * @param data of the value
+     */
+    void Store(std::string_view key, uint64_t version, const Item &item, std::string_view data);
+
+private:
+    struct entry {
+        std::string key;
+        std::string response;
+        uint64_t version = 0;
+        int64_t exptime = 0;
+        uint32_t hits = 0;
+    };
+
+    // Read counts are kept for more hashes than there are entries, so that keys compete for entries only once hot
+    static constexpr std::size_t ReadCounters = 1024;
+
+    static inline std::size_t hash_of(std::string_view key) { return std::hash<std::string_view>()(key); }
+
+    std::vector<entry> _entries;
+    std::vector<uint8_t> _reads;
+    uint32_t _since_decay;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_NEAR_CACHE_H
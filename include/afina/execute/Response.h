@@ -0,0 +1,84 @@
+#ifndef AFINA_EXECUTE_RESPONSE_H
+#define AFINA_EXECUTE_RESPONSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command response builder
+ * Response is a sequence of chunks to be sent with the single writev: text written by the command is kept in the
+ * own buffer, while large value bodies are referenced rather than copied. Referenced memory must stay untouched
+ * until response is sent, so commands reference only buffers they own and reuse on the next Execute.
+ *
+ * Buffers are kept by Clear, so connection that reuses the same response doesn't allocate once they are grown
+ */
+class Response {
+public:
+    Response() {}
+    ~Response() {}
+
+    inline void Clear() {
+        _text.clear();
+        _chunks.clear();
+        _size = 0;
+    }
+
+    inline bool Empty() const { return _size == 0; }
+
+    // Total number of bytes in response
+    inline std::size_t Size() const { return _size; }
+
+    /**
+     * Copies text into the response
+     */
+    Response &Append(std::string_view text);
+
+    /**
+     * Writes decimal number into the response
+     */
+    Response &Append(uint64_t number);
+
+    /**
+     * Adds data to the response without copying it, memory must be valid until response is sent. Small pieces
+     * are copied anyway, iovec for them costs more than copy
+     */
+    Response &Reference(std::string_view data);
+
+    /**
+     * Fills iovecs describing the whole response, they are valid until response is changed
+     */
+    void Iovecs(std::vector<iovec> &iov) const;
+
+    /**
+     * Copies the whole response into out
+     */
+    void Flatten(std::string &out) const;
+
+private:
+    // Referenced data or, if data is nullptr, piece of own text buffer starting at offset
+    struct chunk {
+        const char *data;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    // Appends n bytes to the text, returns pointer to write them to
+    char *grow(std::size_t n);
+
+    std::string _text;
+    std::vector<chunk> _chunks;
+    std::size_t _size = 0;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_RESPONSE_H
@@ -0,0 +1,40 @@
+#ifndef AFINA_EXECUTE_SNAPSHOT_H
+#define AFINA_EXECUTE_SNAPSHOT_H
+
+#include <functional>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Request storage snapshot
+ * snapshot
+ *
+ * Asks server to dump storage into the snapshot file in background. Replies "OK" once snapshot is requested, not
+ * when it is written, or "SERVER_ERROR snapshot is not configured" if server has no snapshot file
+ */
+class Snapshot : public Command {
+public:
+    /**
+     * Starts snapshot, returns false if it can't be taken
+     */
+    using Handler = std::function<bool()>;
+
+    Snapshot() {}
+    ~Snapshot() {}
+
+    /**
+     * Sets process wide handler called by the command, empty one makes command fail
+     */
+    static void SetHandler(const Handler &handler);
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SNAPSHOT_H
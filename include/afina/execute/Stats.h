@@ -2,17 +2,56 @@
 #define AFINA_EXECUTE_STATS_H
 
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "Command.h"
 
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Server statistics
+ * Reports memcached standard statistics: process ones, command and connection counters summed over all threads,
+ * and whatever storage reports about itself, like curr_items, bytes and evictions. "threads" is the number of
+ * threads that have counted anything and are still alive
+ *
+ * stats latency
+ * Reports p50/p90/p99/p99.9/max of every command type and processing phase seen so far, in nanoseconds
+ *
+ * stats hotkeys
+ * Reports most frequently accessed keys with approximate number of accesses as "key:<key> <count>", the most
+ * frequent first, and the sampling rate they are estimated with. Binary protocol keys could have spaces or control
+ * characters that would break the line, such keys are reported hex encoded as "keyhex:<hex> <count>"
+ */
 class Stats : public Command {
 public:
     Stats() {}
     ~Stats() {}
+
+    inline const std::string &group() const { return _group; }
+
+    /**
+     * Reinitializes command for the next request, optional token selects group of statistics
+     */
+    inline void Assign(const std::vector<std::string_view> &tokens) {
+        _group.assign(tokens.empty() ? std::string_view() : tokens[0]);
+    }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    // Appends general statistics
+    void general(Storage &storage, std::vector<std::pair<std::string, std::string>> &stats);
+
+    // Appends latency percentiles
+    void latency(std::vector<std::pair<std::string, std::string>> &stats);
+
+    // Appends hot keys
+    void hotkeys(std::vector<std::pair<std::string, std::string>> &stats);
+
+    std::string _group;
 };
 
 } // namespace Execute
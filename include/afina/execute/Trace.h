@@ -0,0 +1,76 @@
+#ifndef AFINA_EXECUTE_TRACE_H
+#define AFINA_EXECUTE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command trace
+ * Commands record fixed size binary events into the ring buffer of the calling thread: no locks, no formatting and
+ * no syscalls on the request path. Background drainer periodically collects events from all rings and writes them
+ * to the log. If ring is full then event is dropped and counted, request never waits for the drainer.
+ *
+ * Tracing is switched on and off at runtime, while it is off Record costs a single predictable branch
+ */
+class Trace {
+public:
+    enum Op : uint8_t { opGet, opSet, opAdd, opAppend, opReplace, opCas, opIncr, opDecr, opPrepend };
+
+    // Number of key bytes kept in the event, longer keys are truncated
+    static constexpr std::size_t KeySize = 46;
+
+    struct Event {
+        // Nanoseconds since epoch
+        uint64_t time;
+
+        // Data size for store commands, number of keys for get
+        uint32_t size;
+
+        // Sequential number of the thread that has recorded the event
+        uint32_t thread;
+
+        uint8_t op;
+        uint8_t key_size;
+        char key[KeySize];
+    };
+
+    static inline bool Enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    static inline void Enable(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * Records event into the ring of the current thread if tracing is on
+     */
+    static inline void Record(Op op, std::string_view key, std::size_t size) {
+        if (__builtin_expect(Enabled(), 0)) {
+            record(op, key, size);
+        }
+    }
+
+    /**
+     * Passes all events recorded so far to the consumer, ring by ring. Only one thread could drain at a time
+     *
+     * @param consumer function to call for each event
+     * @param dropped output parameter, number of events lost because rings were full
+     * @return number of events drained
+     */
+    static std::size_t Drain(const std::function<void(const Event &)> &consumer, std::size_t &dropped);
+
+    static const char *Name(uint8_t op);
+
+private:
+    static void record(Op op, std::string_view key, std::size_t size);
+
+    static std::atomic<bool> _enabled;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_TRACE_H
@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_VERBOSITY_H
+#define AFINA_EXECUTE_VERBOSITY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change server verbosity
+ * verbosity <level> [noreply]
+ *
+ * Level above 0 switches command tracing on, 0 switches it off. Command replies "OK" unless noreply is given
+ */
+class Verbosity : public Command {
+public:
+    Verbosity() : _level(0), _noreply(false) {}
+    ~Verbosity() {}
+
+    inline int level() const { return _level; }
+
+    /**
+     * Reinitializes command for the next request, tokens must be validated by parser already
+     */
+    void Assign(const std::vector<std::string_view> &tokens);
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    int _level;
+    bool _noreply;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_VERBOSITY_H
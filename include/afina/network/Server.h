@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -18,9 +19,28 @@ namespace Network {
 class Server {
 public:
     Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+        : pStorage(ps), pLogging(pl), nearCacheSize(0), listenSocket(-1) {}
     virtual ~Server() {}
 
+    /**
+     * Makes each worker thread keep near cache of get responses for that many hot keys, see Execute::NearCache.
+     * Must be called before Start, 0 switches cache off. Servers without long living workers ignore it
+     */
+    void SetNearCache(std::size_t entries) { nearCacheSize = entries; }
+
+    /**
+     * Makes Start accept connections on the given socket, which is bound and listening already, instead of opening
+     * a new one on the port, e.g. socket handed over by the previous process on graceful restart. Must be called
+     * before Start, server owns the socket then
+     */
+    void SetListenSocket(int socket) { listenSocket = socket; }
+
+    /**
+     * Returns socket the server accepts connections on, -1 until it is started. Stop doesn't shut the socket down,
+     * so the socket passed to another process keeps listening there once this server is stopped
+     */
+    int ListenSocket() const { return listenSocket; }
+
     /**
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
@@ -55,6 +75,16 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Number of keys in the near cache of each worker, 0 if there is no cache
+     */
+    std::size_t nearCacheSize;
+
+    /**
+     * Socket to accept connections on, -1 if server opens it by itself on start
+     */
+    int listenSocket;
 };
 
 } // namespace Network
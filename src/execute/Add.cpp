@@ -1,7 +1,8 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
 #include <afina/execute/Add.h>
-
-#include <iostream>
+#include <afina/execute/Trace.h>
 
 namespace Afina {
 namespace Execute {
@@ -9,8 +10,15 @@ namespace Execute {
 // memcached protocol:  "add" means "store this data, but only if the server *doesn't* already
 // hold data for this key".
 void Add::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Add(" << _key << ")" << args << std::endl;
-    out = storage.PutIfAbsent(_key, args) ? "STORED" : "NOT_STORED";
+    Trace::Record(Trace::opAdd, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    // Expired item doesn't count, add overwrites it
+    int64_t now = Item::Now();
+    encode(args, _stored);
+    bool stored = storage.Add(_key, _stored, [now](const std::string &current) { return Item::Live(current, now); });
+    out = stored ? "STORED" : "NOT_STORED";
 }
 
 } // namespace Execute
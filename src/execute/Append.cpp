@@ -1,21 +1,28 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
 #include <afina/execute/Append.h>
-
-#include <iostream>
+#include <afina/execute/Trace.h>
 
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Append(" << _key << ")" << args << std::endl;
-    std::string value;
-    if (!storage.Get(_key, value)) {
-        out.assign("NOT_STORED");
-        return;
-    }
-    storage.Put(_key, value + args);
-    out.assign("STORED");
+    Trace::Record(Trace::opAppend, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    // Flags and expiration time are kept as is, data is added to the stored value in place
+    int64_t now = Item::Now();
+    bool stored = storage.Append(_key, args, [now](std::string &current) {
+        if (!Item::Live(current, now)) {
+            return false;
+        }
+        Item::SetCas(current, Item::NextCas());
+        return true;
+    });
+    out = stored ? "STORED" : "NOT_STORED";
 }
 
 } // namespace Execute
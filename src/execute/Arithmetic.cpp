@@ -0,0 +1,46 @@
+#include <afina/Storage.h>
+#include <afina/execute/Arithmetic.h>
+#include <afina/execute/Item.h>
+#include <afina/execute/Trace.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Arithmetic.h
+void Arithmetic::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Trace::Record(_decrement ? Trace::opDecr : Trace::opIncr, _key, 0);
+
+    int64_t now = Item::Now();
+    const char *status = "NOT_FOUND";
+    bool stored = storage.Update(_key, [&](const std::string *current, std::string &updated) {
+        Item item;
+        std::string_view data;
+        uint64_t value;
+        if (!Item::Live(current, now, item, data)) {
+            return Storage::UpdateAction::Keep;
+        } else if (!Item::Counter(data, value)) {
+            status = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+            return Storage::UpdateAction::Keep;
+        }
+
+        if (_decrement) {
+            value = value > _delta ? value - _delta : 0;
+        } else {
+            value += _delta;
+        }
+
+        _value = std::to_string(value);
+        item.cas = Item::NextCas();
+        Item::Encode(item, _value, updated);
+        return Storage::UpdateAction::Store;
+    });
+
+    if (stored) {
+        out = _value;
+    } else {
+        out = status;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
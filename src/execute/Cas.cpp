@@ -0,0 +1,37 @@
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Trace.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" is a check and set operation which means "store this data but only if no one else
+// has updated since I last fetched it."
+void Cas::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Trace::Record(Trace::opCas, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    int64_t now = Item::Now();
+    const char *status = "NOT_FOUND";
+    storage.Update(_key, [&](const std::string *current, std::string &updated) {
+        Item item;
+        std::string_view data;
+        if (!Item::Live(current, now, item, data)) {
+            return Storage::UpdateAction::Keep;
+        } else if (item.cas != _cas) {
+            status = "EXISTS";
+            return Storage::UpdateAction::Keep;
+        }
+
+        encode(args, updated);
+        status = "STORED";
+        return Storage::UpdateAction::Store;
+    });
+    out = status;
+}
+
+} // namespace Execute
+} // namespace Afina
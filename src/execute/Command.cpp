@@ -1 +1,14 @@
 #include <afina/execute/Command.h>
+#include <afina/execute/Response.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Command.h
+void Command::Execute(Storage &storage, const std::string &args, Response &out) {
+    Execute(storage, args, _text);
+    out.Append(_text);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,76 @@
+#include <afina/execute/Counters.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+thread_local Counters::Slot *Counters::_local = nullptr;
+
+// Slots of running threads and counters of exited ones
+static std::mutex registry_mutex;
+static std::vector<Counters::Slot *> registry;
+static int64_t retired[Counters::Count] = {0};
+
+// Owns slot of the thread, folds its counters into retired ones on thread exit
+struct counters_slot_owner {
+    Counters::Slot slot;
+
+    counters_slot_owner() {
+        std::unique_lock<std::mutex> lock(registry_mutex);
+        registry.push_back(&slot);
+    }
+
+    ~counters_slot_owner() {
+        std::unique_lock<std::mutex> lock(registry_mutex);
+        for (std::size_t i = 0; i < Counters::Count; i++) {
+            retired[i] += slot.values[i].load(std::memory_order_relaxed);
+        }
+        registry.erase(std::find(registry.begin(), registry.end(), &slot));
+    }
+};
+
+// See Counters.h
+Counters::Slot &Counters::attach() {
+    thread_local counters_slot_owner owner;
+    return owner.slot;
+}
+
+// See Counters.h
+std::size_t Counters::Collect(int64_t *totals) {
+    std::unique_lock<std::mutex> lock(registry_mutex);
+    std::copy(retired, retired + Count, totals);
+    for (Slot *slot : registry) {
+        for (std::size_t i = 0; i < Count; i++) {
+            totals[i] += slot->values[i].load(std::memory_order_relaxed);
+        }
+    }
+    return registry.size();
+}
+
+// See Counters.h
+const char *Counters::Name(Counter counter) {
+    switch (counter) {
+    case cmdGet:
+        return "cmd_get";
+    case cmdSet:
+        return "cmd_set";
+    case getHits:
+        return "get_hits";
+    case getMisses:
+        return "get_misses";
+    case currConnections:
+        return "curr_connections";
+    case totalConnections:
+        return "total_connections";
+    case nearCacheHits:
+        return "near_cache_hits";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,9 +1,9 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
 #include <afina/execute/Get.h>
-
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Item.h>
+#include <afina/execute/Trace.h>
 
 namespace Afina {
 namespace Execute {
@@ -12,7 +12,7 @@ namespace Execute {
 
 Each item sent by the server looks like this:
 
-VALUE <key> <flags> <bytes>\r\n
+VALUE <key> <flags> <bytes> [<cas unique>]\r\n
 <data block>\r\n
 
 After all the items have been transmitted, the server sends the string
@@ -21,23 +21,80 @@ to indicate the end of response.
 
 */
 
+// See Get.h
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
+    _response.Clear();
+    Execute(storage, args, _response);
+    _response.Flatten(out);
+}
+
+// See Get.h
+void Get::Execute(Storage &storage, const std::string &args, Response &out) {
+    Trace::Record(Trace::opGet, _keys.empty() ? std::string_view() : _keys[0], _keys.size());
+
+    int64_t now = Item::Now();
+    NearCache *near = _with_cas ? nullptr : _near;
+
+    // Keys found in near cache aren't read from storage at all
+    const std::vector<std::string_view> *read = &_keys;
+    if (near != nullptr) {
+        _cached.resize(_keys.size());
+        _misses.clear();
+        _versions.clear();
+        for (std::size_t i = 0; i < _keys.size(); i++) {
+            _cached[i] = near->Find(storage, _keys[i], now);
+            if (_cached[i] == nullptr) {
+                _misses.push_back(_keys[i]);
+                _versions.push_back(near->Admit(storage, _keys[i]));
+            }
+        }
+        read = &_misses;
+    }
+
+    // All keys are read at once, so that storage could take its locks once per batch instead of once per key
+    storage.MultiGet(*read, _values, _found);
 
-    std::stringstream outStream;
+    int64_t hits = 0, near_hits = 0;
+    for (std::size_t i = 0, j = 0; i < _keys.size(); i++) {
+        HotKeys::Record(_keys[i]);
+        if (near != nullptr && _cached[i] != nullptr) {
+            out.Append(*_cached[i]);
+            hits++;
+            near_hits++;
+            continue;
+        }
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+        Item item;
+        std::string_view data;
+        std::size_t read_index = j++;
+        if (!_found[read_index] || !Item::Live(&_values[read_index], now, item, data))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        hits++;
+        out.Append("VALUE ").Append(_keys[i]).Append(" ").Append(uint64_t(item.flags)).Append(" ");
+        out.Append(uint64_t(data.size()));
+        if (_with_cas) {
+            out.Append(" ").Append(item.cas);
+        }
+        out.Append("\r\n");
+        out.Reference(data).Append("\r\n");
+    }
+    out.Append("END"); // networking layer should add the last \r\n
+
+    // Cached responses are copied out already, so entries could be replaced now
+    if (near != nullptr) {
+        for (std::size_t j = 0; j < _misses.size(); j++) {
+            Item item;
+            std::string_view data;
+            if (_versions[j] != 0 && _found[j] && Item::Live(&_values[j], now, item, data)) {
+                near->Store(_misses[j], _versions[j], item, data);
+            }
+        }
+        Counters::Add(Counters::nearCacheHits, near_hits);
     }
-    outStream << "END"; // networking layer should add the last \r\n
 
-    out = outStream.str();
+    Counters::Add(Counters::cmdGet, _keys.size());
+    Counters::Add(Counters::getHits, hits);
+    Counters::Add(Counters::getMisses, _keys.size() - hits);
 }
 
 } // namespace Execute
@@ -0,0 +1,106 @@
+#include <afina/execute/HotKeys.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Execute {
+
+std::atomic<uint32_t> HotKeys::_sampling(100);
+
+thread_local int64_t HotKeys::_countdown = 0;
+
+// Space-saving sketch of a single thread. Owner takes the lock only for sampled accesses, so it is uncontended
+// unless somebody collects the top at the same moment
+struct hotkeys_sketch {
+    std::mutex mutex;
+    std::vector<HotKeys::Entry> entries;
+    uint64_t samples = 0;
+
+    // xorshift state used to jitter distance between samples
+    uint64_t random = 0;
+};
+
+// Sketches of exited threads are reused by new ones
+static Concurrency::ThreadLocal<hotkeys_sketch> sketches;
+
+// See HotKeys.h
+void HotKeys::record(std::string_view key) {
+    uint32_t sampling = Sampling();
+    hotkeys_sketch &sketch = sketches.get();
+
+    // Distance to the next sample is uniform in [1, 2 * sampling - 1], so the mean is still sampling but keys
+    // accessed in a fixed period don't get always sampled or always skipped
+    if (sketch.random == 0) {
+        sketch.random = uint64_t(reinterpret_cast<uintptr_t>(&sketch) >> 4) | 1;
+    }
+    sketch.random ^= sketch.random << 13;
+    sketch.random ^= sketch.random >> 7;
+    sketch.random ^= sketch.random << 17;
+    _countdown = int64_t(1 + sketch.random % (2 * uint64_t(sampling) - 1));
+
+    std::unique_lock<std::mutex> lock(sketch.mutex);
+    if (++sketch.samples % DecayPeriod == 0) {
+        for (auto &entry : sketch.entries) {
+            entry.count /= 2;
+            entry.error /= 2;
+        }
+        sketch.entries.erase(std::remove_if(sketch.entries.begin(), sketch.entries.end(),
+                                            [](const Entry &entry) { return entry.count == 0; }),
+                             sketch.entries.end());
+    }
+
+    // Each sample stands for sampling accesses
+    Entry *min = nullptr;
+    for (auto &entry : sketch.entries) {
+        if (entry.key == key) {
+            entry.count += sampling;
+            return;
+        }
+        if (min == nullptr || entry.count < min->count) {
+            min = &entry;
+        }
+    }
+
+    if (sketch.entries.size() < Capacity) {
+        sketch.entries.push_back(Entry{std::string(key), sampling, 0});
+    } else {
+        min->key.assign(key);
+        min->error = min->count;
+        min->count += sampling;
+    }
+}
+
+// See HotKeys.h
+void HotKeys::Collect(std::size_t limit, std::vector<Entry> &top) {
+    std::unordered_map<std::string, Entry> merged;
+    sketches.for_each([&](hotkeys_sketch &sketch) {
+        std::unique_lock<std::mutex> lock(sketch.mutex);
+        for (auto &entry : sketch.entries) {
+            auto it = merged.emplace(entry.key, Entry{entry.key, 0, 0}).first;
+            it->second.count += entry.count;
+            it->second.error += entry.error;
+        }
+    });
+
+    top.clear();
+    top.reserve(merged.size());
+    for (auto &it : merged) {
+        top.push_back(std::move(it.second));
+    }
+
+    auto by_count = [](const Entry &a, const Entry &b) { return a.count > b.count; };
+    if (top.size() > limit) {
+        std::partial_sort(top.begin(), top.begin() + limit, top.end(), by_count);
+        top.resize(limit);
+    } else {
+        std::sort(top.begin(), top.end(), by_count);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
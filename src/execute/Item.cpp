@@ -0,0 +1,91 @@
+#include <afina/execute/Item.h>
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+namespace Afina {
+namespace Execute {
+
+// Header layout: flags(4) state(1) reserved(3) exptime(8) cas(8), host byte order
+static_assert(Item::HeaderSize == 4 + 1 + 3 + 8 + 8, "Item header layout mismatch");
+
+// Relative expiration times are limited by 30 days, like in memcached
+static constexpr int64_t max_relative_exptime = 60 * 60 * 24 * 30;
+
+// See Item.h
+bool Item::Decode(const std::string &stored, Item &item, std::string_view &data) {
+    if (stored.size() < HeaderSize) {
+        return false;
+    }
+
+    const char *p = stored.data();
+    std::memcpy(&item.flags, p, 4);
+    item.state = p[4];
+    std::memcpy(&item.exptime, p + 8, 8);
+    std::memcpy(&item.cas, p + 16, 8);
+    data = std::string_view(p + HeaderSize, stored.size() - HeaderSize);
+    return true;
+}
+
+// See Item.h
+void Item::Encode(const Item &item, std::string_view data, std::string &stored) {
+    char header[HeaderSize] = {0};
+    std::memcpy(header, &item.flags, 4);
+    header[4] = item.state;
+    std::memcpy(header + 8, &item.exptime, 8);
+    std::memcpy(header + 16, &item.cas, 8);
+
+    stored.assign(header, HeaderSize);
+    stored.append(data);
+}
+
+// See Item.h
+void Item::SetCas(std::string &stored, uint64_t cas) { std::memcpy(&stored[16], &cas, 8); }
+
+// See Item.h
+int64_t Item::ExpireAt(int64_t exptime, int64_t now) {
+    if (exptime == 0) {
+        return 0;
+    } else if (exptime < 0) {
+        return 1;
+    } else if (exptime <= max_relative_exptime) {
+        return now + exptime;
+    }
+    return exptime;
+}
+
+// See Item.h
+uint64_t Item::NextCas() {
+    static std::atomic<uint64_t> cas(0);
+    return cas.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// See Item.h
+bool Item::Counter(std::string_view data, uint64_t &value) {
+    if (data.empty() || data.size() > std::numeric_limits<uint64_t>::digits10 + 1) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (char c : data) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        uint64_t next = result * 10 + (c - '0');
+        if (next / 10 != result) {
+            // Overflow
+            return false;
+        }
+        result = next;
+    }
+    value = result;
+    return true;
+}
+
+// See Item.h
+int64_t Item::Now() { return std::time(nullptr); }
+
+} // namespace Execute
+} // namespace Afina
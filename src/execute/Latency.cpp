@@ -0,0 +1,109 @@
+#include <afina/execute/Latency.h>
+
+#include <algorithm>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Execute {
+
+static_assert(Latency::BucketLimit(Latency::Buckets - 1) == (uint64_t(1) << Latency::MaxBits) - 1,
+              "The last bucket must end at the histogram limit");
+
+// Histograms of a single thread. Written only by the owner thread, so plain load and store are enough
+struct latency_slot {
+    std::atomic<uint64_t> counts[Latency::OpCount][Latency::PhaseCount][Latency::Buckets];
+    std::atomic<uint64_t> max[Latency::OpCount][Latency::PhaseCount];
+};
+
+// Slots of exited threads are reused by new ones, so nothing recorded is lost
+static Concurrency::ThreadLocal<latency_slot> slots;
+
+// See Latency.h
+void Latency::Record(Op op, Phase phase, uint64_t nanoseconds) {
+    latency_slot &slot = slots.get();
+    std::atomic<uint64_t> &count = slot.counts[op][phase][Bucket(nanoseconds)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    std::atomic<uint64_t> &max = slot.max[op][phase];
+    if (nanoseconds > max.load(std::memory_order_relaxed)) {
+        max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+// See Latency.h
+void Latency::Collect(Op op, Phase phase, Snapshot &snapshot) {
+    std::fill(snapshot.counts, snapshot.counts + Buckets, 0);
+    snapshot.total = snapshot.max = 0;
+
+    slots.for_each([&](latency_slot &slot) {
+        for (std::size_t i = 0; i < Buckets; i++) {
+            uint64_t count = slot.counts[op][phase][i].load(std::memory_order_relaxed);
+            snapshot.counts[i] += count;
+            snapshot.total += count;
+        }
+        snapshot.max = std::max(snapshot.max, slot.max[op][phase].load(std::memory_order_relaxed));
+    });
+}
+
+// See Latency.h
+uint64_t Latency::Snapshot::Percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+
+    // Rank of the value in the sorted list of all recorded ones, starting from 1
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(fraction * total + 0.5));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < Buckets; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(BucketLimit(i), max);
+        }
+    }
+    return max;
+}
+
+// See Latency.h
+Latency::Op Latency::OpOf(std::string_view name) {
+    if (name == "get" || name == "gets") {
+        return opGet;
+    } else if (name == "set") {
+        return opSet;
+    } else if (name == "add") {
+        return opAdd;
+    } else if (name == "replace") {
+        return opReplace;
+    } else if (name == "append") {
+        return opAppend;
+    } else if (name == "prepend") {
+        return opPrepend;
+    } else if (name == "cas") {
+        return opCas;
+    } else if (name == "incr") {
+        return opIncr;
+    } else if (name == "decr") {
+        return opDecr;
+    } else if (name == "delete") {
+        return opDelete;
+    } else if (name.size() == 2 && name[0] == 'm') {
+        return opMeta;
+    }
+    return opOther;
+}
+
+// See Latency.h
+const char *Latency::Name(Op op) {
+    static const char *names[OpCount] = {"get", "set",  "add",  "replace", "append", "prepend",
+                                         "cas", "incr", "decr", "delete",  "meta",   "other"};
+    return op < OpCount ? names[op] : "unknown";
+}
+
+// See Latency.h
+const char *Latency::Name(Phase phase) {
+    static const char *names[PhaseCount] = {"parse", "storage", "write"};
+    return phase < PhaseCount ? names[phase] : "unknown";
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,73 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaArithmetic.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaArithmetic.h
+void MetaArithmetic::Execute(Storage &storage, const std::string &args, std::string &out) {
+    int64_t now = Item::Now();
+    int64_t delta = 1, initial = 0, vivify_ttl, ttl, compare;
+    if (flag('D') && (!number_flag('D', delta) || delta < 0)) {
+        out.assign("CLIENT_ERROR bad delta");
+        return;
+    }
+    number_flag('J', initial);
+    bool vivify = number_flag('N', vivify_ttl);
+    bool has_ttl = number_flag('T', ttl);
+    bool has_compare = number_flag('C', compare);
+
+    std::string_view mode_arg;
+    bool decrement = flag('M', mode_arg) && !mode_arg.empty() &&
+                     (mode_arg[0] == 'D' || mode_arg[0] == 'd' || mode_arg[0] == '-');
+
+    Item item;
+    uint64_t value = 0;
+    const char *status = "HD";
+    storage.Update(_key, [&](const std::string *current, std::string &updated) {
+        std::string_view data;
+        if (!Item::Live(current, now, item, data)) {
+            if (!vivify) {
+                status = "NF";
+                return Storage::UpdateAction::Keep;
+            }
+            item = Item();
+            item.exptime = Item::ExpireAt(vivify_ttl, now);
+            value = uint64_t(initial);
+        } else if (has_compare && uint64_t(compare) != item.cas) {
+            status = "EX";
+            return Storage::UpdateAction::Keep;
+        } else if (!Item::Counter(data, value)) {
+            status = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+            return Storage::UpdateAction::Keep;
+        } else if (decrement) {
+            value = value > uint64_t(delta) ? value - delta : 0;
+        } else {
+            value += delta;
+        }
+
+        if (has_ttl) {
+            item.exptime = Item::ExpireAt(ttl, now);
+        }
+        item.state = 0;
+        item.cas = Item::NextCas();
+        _value = std::to_string(value);
+        Item::Encode(item, _value, updated);
+        return Storage::UpdateAction::Store;
+    });
+
+    out.clear();
+    if (status[0] != 'H') {
+        out.append(status);
+    } else if (flag('v')) {
+        out.append("VA ").append(std::to_string(_value.size()));
+        return_flags(out, &item, _value.size(), now);
+        out.append("\r\n").append(_value); // networking layer should add the last \r\n
+    } else if (!quiet()) {
+        out.append("HD");
+        return_flags(out, &item, _value.size(), now);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,86 @@
+#include <afina/execute/MetaCommand.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaCommand.h
+void MetaCommand::Assign(const std::vector<std::string_view> &tokens, std::size_t skip) {
+    _key.assign(tokens.empty() ? std::string_view() : tokens[0]);
+    _flags.clear();
+    for (std::size_t i = skip; i < tokens.size(); i++) {
+        if (!tokens[i].empty()) {
+            _flags.append(tokens[i]).push_back(' ');
+        }
+    }
+}
+
+// See MetaCommand.h
+bool MetaCommand::flag(char f, std::string_view &arg) const {
+    for (std::size_t pos = 0; pos < _flags.size();) {
+        std::size_t end = _flags.find(' ', pos);
+        if (_flags[pos] == f) {
+            arg = std::string_view(_flags.data() + pos + 1, end - pos - 1);
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+// See MetaCommand.h
+bool MetaCommand::number_flag(char f, int64_t &value) const {
+    std::string_view arg;
+    if (!flag(f, arg) || arg.empty() || arg.size() > 18) {
+        return false;
+    }
+
+    bool negative = (arg[0] == '-');
+    if (negative) {
+        arg.remove_prefix(1);
+    }
+
+    int64_t result = 0;
+    for (char c : arg) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    value = negative ? -result : result;
+    return !arg.empty();
+}
+
+// See MetaCommand.h
+void MetaCommand::return_flags(std::string &out, const Item *item, std::size_t size, int64_t now) const {
+    for (std::size_t pos = 0; pos < _flags.size();) {
+        std::size_t end = _flags.find(' ', pos);
+        char f = _flags[pos];
+        if (f == 'O') {
+            out.push_back(' ');
+            out.append(_flags, pos, end - pos);
+        } else if (f == 'k') {
+            out.append(" k").append(_key);
+        } else if (item != nullptr) {
+            switch (f) {
+            case 'c':
+                out.append(" c").append(std::to_string(item->cas));
+                break;
+            case 'f':
+                out.append(" f").append(std::to_string(item->flags));
+                break;
+            case 's':
+                out.append(" s").append(std::to_string(size));
+                break;
+            case 't':
+                out.append(" t").append(std::to_string(item->TTL(now)));
+                break;
+            default:
+                break;
+            }
+        }
+        pos = end + 1;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
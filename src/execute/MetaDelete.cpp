@@ -0,0 +1,46 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaDelete.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaDelete.h
+void MetaDelete::Execute(Storage &storage, const std::string &args, std::string &out) {
+    int64_t now = Item::Now();
+    int64_t ttl, compare;
+    bool has_ttl = number_flag('T', ttl);
+    bool has_compare = number_flag('C', compare);
+    bool invalidate = flag('I');
+
+    const char *status = "HD";
+    storage.Update(_key, [&](const std::string *current, std::string &updated) {
+        Item item;
+        std::string_view data;
+        if (!Item::Live(current, now, item, data)) {
+            status = "NF";
+            return Storage::UpdateAction::Keep;
+        } else if (has_compare && uint64_t(compare) != item.cas) {
+            status = "EX";
+            return Storage::UpdateAction::Keep;
+        } else if (!invalidate) {
+            return Storage::UpdateAction::Remove;
+        }
+
+        // Stale item gets new recache winner
+        item.state = Item::sStale;
+        if (has_ttl) {
+            item.exptime = Item::ExpireAt(ttl, now);
+        }
+        Item::Encode(item, data, updated);
+        return Storage::UpdateAction::Store;
+    });
+
+    out.clear();
+    if (status[0] == 'E' || !quiet()) {
+        out.append(status);
+        return_flags(out, nullptr, 0, now);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
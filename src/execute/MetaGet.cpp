@@ -0,0 +1,107 @@
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/MetaGet.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaGet.h
+void MetaGet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    int64_t now = Item::Now();
+    int64_t touch_ttl, vivify_ttl, recache_ttl;
+    bool touch = number_flag('T', touch_ttl);
+    bool vivify = number_flag('N', vivify_ttl);
+    bool recache = number_flag('R', recache_ttl);
+
+    Item item;
+    std::string_view data;
+    bool hit = storage.Get(_key, _value) && Item::Live(&_value, now, item, data);
+
+    // Stale item or the one that is about to expire must be recached by the single client
+    auto needs_recache = [&](const Item &it) {
+        return (it.state & Item::sStale) || (recache && it.TTL(now) >= 0 && it.TTL(now) < recache_ttl);
+    };
+
+    // Item state changes only if client could win recache or asked for touch, everything else is a plain read
+    bool win = false;
+    bool win_sent = hit && (item.state & Item::sWinSent);
+    bool could_win = hit ? needs_recache(item) : vivify;
+    if (touch || (could_win && !win_sent)) {
+        storage.Update(_key, [&](const std::string *current, std::string &updated) {
+            hit = Item::Live(current, now, item, data);
+            if (!hit) {
+                if (!vivify) {
+                    return Storage::UpdateAction::Keep;
+                }
+
+                // Placeholder that tells others somebody is filling it already
+                item = Item();
+                item.state = Item::sWinSent;
+                item.exptime = Item::ExpireAt(vivify_ttl, now);
+                item.cas = Item::NextCas();
+                Item::Encode(item, std::string_view(), _value);
+                updated = _value;
+                hit = win = true;
+                return Storage::UpdateAction::Store;
+            }
+
+            bool changed = false;
+            win_sent = (item.state & Item::sWinSent);
+            if (!win_sent && needs_recache(item)) {
+                item.state |= Item::sWinSent;
+                win = changed = true;
+            }
+            if (touch) {
+                item.exptime = Item::ExpireAt(touch_ttl, now);
+                changed = true;
+            }
+
+            // Current value lives in storage, keep own copy of it to build response out of
+            Item::Encode(item, data, _value);
+            if (!changed) {
+                return Storage::UpdateAction::Keep;
+            }
+            updated = _value;
+            return Storage::UpdateAction::Store;
+        });
+
+        if (hit) {
+            Item::Decode(_value, item, data);
+        }
+    }
+
+    Counters::Add(Counters::cmdGet);
+    HotKeys::Record(_key);
+    Counters::Add(hit ? Counters::getHits : Counters::getMisses);
+
+    out.clear();
+    if (!hit) {
+        if (!quiet()) {
+            out.append("EN");
+        }
+        return;
+    }
+
+    bool value = flag('v');
+    out.append(value ? "VA " : "HD");
+    if (value) {
+        out.append(std::to_string(data.size()));
+    }
+    return_flags(out, &item, data.size(), now);
+    if (win) {
+        out.append(" W");
+    }
+    if (item.state & Item::sStale) {
+        out.append(" X");
+    }
+    if (win_sent && !win) {
+        out.append(" Z");
+    }
+    if (value) {
+        out.append("\r\n").append(data); // networking layer should add the last \r\n
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
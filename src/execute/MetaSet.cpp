@@ -0,0 +1,92 @@
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/MetaSet.h>
+
+#include <cctype>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaSet.h
+void MetaSet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    int64_t now = Item::Now();
+    int64_t flags, ttl, compare;
+    bool has_flags = number_flag('F', flags);
+    bool has_ttl = number_flag('T', ttl);
+    bool has_compare = number_flag('C', compare);
+    bool invalidate = flag('I');
+
+    std::string_view mode_arg;
+    char mode = flag('M', mode_arg) && !mode_arg.empty() ? std::toupper(mode_arg[0]) : 'S';
+    if (mode != 'E' && mode != 'A' && mode != 'P' && mode != 'R' && mode != 'S') {
+        out.assign("CLIENT_ERROR invalid mode");
+        return;
+    }
+    bool add = (mode == 'E');
+    bool append = (mode == 'A');
+    bool prepend = (mode == 'P');
+
+    Item item;
+    std::size_t size = 0;
+    const char *status = "NS";
+    bool stored = storage.Update(_key, [&](const std::string *current, std::string &updated) {
+        Item old;
+        std::string_view data;
+        bool hit = Item::Live(current, now, old, data);
+
+        bool stale = false;
+        if (has_compare) {
+            if (!hit) {
+                status = "NF";
+                return Storage::UpdateAction::Keep;
+            } else if (uint64_t(compare) != old.cas) {
+                if (!invalidate || uint64_t(compare) > old.cas) {
+                    status = "EX";
+                    return Storage::UpdateAction::Keep;
+                }
+                stale = true;
+            }
+        }
+
+        // Add needs item to be absent, append, prepend and replace need it to be there
+        if ((add && hit) || (mode != 'S' && !add && !hit)) {
+            return Storage::UpdateAction::Keep;
+        }
+
+        // Append and prepend keep item metadata unless client overrides it
+        if (!append && !prepend) {
+            old = Item();
+        }
+        item.flags = has_flags ? uint32_t(flags) : old.flags;
+        item.exptime = has_ttl ? Item::ExpireAt(ttl, now) : old.exptime;
+        item.state = stale ? Item::sStale : 0;
+        item.cas = Item::NextCas();
+
+        if (append) {
+            Item::Encode(item, data, updated);
+            updated.append(args);
+        } else if (prepend) {
+            Item::Encode(item, args, updated);
+            updated.append(data);
+        } else {
+            Item::Encode(item, args, updated);
+        }
+        size = updated.size() - Item::HeaderSize;
+        return Storage::UpdateAction::Store;
+    });
+
+    out.clear();
+    if (!stored) {
+        out.append(status);
+    } else if (!quiet()) {
+        out.append("HD");
+        return_flags(out, &item, size, now);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,72 @@
+#include <afina/Storage.h>
+#include <afina/execute/Item.h>
+#include <afina/execute/NearCache.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Execute {
+
+// See NearCache.h
+NearCache::NearCache(std::size_t capacity) : _entries(capacity), _reads(ReadCounters, 0), _since_decay(0) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Near cache needs at least one entry");
+    }
+}
+
+// See NearCache.h
+const std::string *NearCache::Find(Storage &storage, std::string_view key, int64_t now) {
+    entry &e = _entries[hash_of(key) % _entries.size()];
+    if (e.version == 0 || e.key != key) {
+        return nullptr;
+    }
+
+    // Key has been written or evicted since response was cached
+    if ((e.exptime != 0 && e.exptime <= now) || storage.Version(key) != e.version) {
+        e.version = 0;
+        return nullptr;
+    }
+
+    if (++e.hits % TouchPeriod == 0) {
+        storage.Touch(e.key);
+    }
+    return &e.response;
+}
+
+// See NearCache.h
+uint64_t NearCache::Admit(Storage &storage, std::string_view key) {
+    if (++_since_decay == DecayPeriod) {
+        _since_decay = 0;
+        for (auto &reads : _reads) {
+            reads /= 2;
+        }
+    }
+
+    uint8_t &reads = _reads[hash_of(key) % ReadCounters];
+    if (reads < HotReads) {
+        reads++;
+        return 0;
+    }
+
+    // Version must be taken before value is read: if write happens in between then entry is stale from the start
+    return storage.Version(key);
+}
+
+// See NearCache.h
+void NearCache::Store(std::string_view key, uint64_t version, const Item &item, std::string_view data) {
+    if (version == 0 || data.size() > MaxValueSize) {
+        return;
+    }
+
+    // Same as get encodes item, see Get.cpp
+    entry &e = _entries[hash_of(key) % _entries.size()];
+    e.key.assign(key);
+    e.response.assign("VALUE ").append(key).append(" ");
+    e.response.append(std::to_string(item.flags)).append(" ").append(std::to_string(data.size())).append("\r\n");
+    e.response.append(data).append("\r\n");
+    e.version = version;
+    e.exptime = item.exptime;
+}
+
+} // namespace Execute
+} // namespace Afina
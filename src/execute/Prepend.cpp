@@ -0,0 +1,29 @@
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Trace.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "prepend" means "add this data to an existing key before existing data".
+void Prepend::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Trace::Record(Trace::opPrepend, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    // Data goes right after the item header, flags and expiration time are kept as is
+    int64_t now = Item::Now();
+    bool stored = storage.Insert(_key, args, Item::HeaderSize, [now](std::string &current) {
+        if (!Item::Live(current, now)) {
+            return false;
+        }
+        Item::SetCas(current, Item::NextCas());
+        return true;
+    });
+    out = stored ? "STORED" : "NOT_STORED";
+}
+
+} // namespace Execute
+} // namespace Afina
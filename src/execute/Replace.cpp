@@ -1,7 +1,8 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
 #include <afina/execute/Replace.h>
-
-#include <iostream>
+#include <afina/execute/Trace.h>
 
 namespace Afina {
 namespace Execute {
@@ -10,14 +11,15 @@ namespace Execute {
 // already hold data for this key".
 
 void Replace::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Replace(" << _key << "): " << args << std::endl;
-    std::string value;
-    if (storage.Get(_key, value)) {
-        storage.Set(_key, args);
-        out = "STORED";
-    } else {
-        out = "NOT_STORED";
-    }
+    Trace::Record(Trace::opReplace, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+
+    int64_t now = Item::Now();
+    encode(args, _stored);
+    bool stored =
+        storage.Replace(_key, _stored, [now](const std::string &current) { return Item::Live(current, now); });
+    out = stored ? "STORED" : "NOT_STORED";
 }
 
 } // namespace Execute
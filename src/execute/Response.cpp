@@ -0,0 +1,95 @@
+#include <afina/execute/Response.h>
+
+#include <cstring>
+
+namespace Afina {
+namespace Execute {
+
+// Data smaller than that is copied by Reference
+static constexpr std::size_t min_reference_size = 128;
+
+// Decimal representation of all two digit numbers, number is formatted by two digits at once
+static const char digit_pairs[201] = "00010203040506070809"
+                                     "10111213141516171819"
+                                     "20212223242526272829"
+                                     "30313233343536373839"
+                                     "40414243444546474849"
+                                     "50515253545556575859"
+                                     "60616263646566676869"
+                                     "70717273747576777879"
+                                     "80818283848586878889"
+                                     "90919293949596979899";
+
+// See Response.h
+char *Response::grow(std::size_t n) {
+    // Text appended right after previous text piece extends it
+    if (_chunks.empty() || _chunks.back().data != nullptr) {
+        _chunks.push_back(chunk{nullptr, _text.size(), 0});
+    }
+    _chunks.back().size += n;
+    _size += n;
+
+    std::size_t offset = _text.size();
+    _text.resize(offset + n);
+    return &_text[offset];
+}
+
+// See Response.h
+Response &Response::Append(std::string_view text) {
+    if (!text.empty()) {
+        std::memcpy(grow(text.size()), text.data(), text.size());
+    }
+    return *this;
+}
+
+// See Response.h
+Response &Response::Append(uint64_t number) {
+    // Digits are written from the end of the local buffer
+    char buffer[20];
+    char *p = buffer + sizeof(buffer);
+    while (number >= 100) {
+        std::size_t pair = (number % 100) * 2;
+        number /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (number >= 10) {
+        *--p = digit_pairs[number * 2 + 1];
+        *--p = digit_pairs[number * 2];
+    } else {
+        *--p = char('0' + number);
+    }
+    return Append(std::string_view(p, buffer + sizeof(buffer) - p));
+}
+
+// See Response.h
+Response &Response::Reference(std::string_view data) {
+    if (data.size() < min_reference_size) {
+        return Append(data);
+    }
+
+    _chunks.push_back(chunk{data.data(), 0, data.size()});
+    _size += data.size();
+    return *this;
+}
+
+// See Response.h
+void Response::Iovecs(std::vector<iovec> &iov) const {
+    iov.clear();
+    for (auto &c : _chunks) {
+        const char *base = c.data != nullptr ? c.data : _text.data() + c.offset;
+        iov.push_back(iovec{const_cast<char *>(base), c.size});
+    }
+}
+
+// See Response.h
+void Response::Flatten(std::string &out) const {
+    out.clear();
+    out.reserve(_size);
+    for (auto &c : _chunks) {
+        out.append(c.data != nullptr ? c.data : _text.data() + c.offset, c.size);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,16 +1,19 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
 #include <afina/execute/Set.h>
-
-#include <iostream>
+#include <afina/execute/Trace.h>
 
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "set" means "store this data".
 void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
-    out = "STORED";
+    Trace::Record(Trace::opSet, _key, args.size());
+    Counters::Add(Counters::cmdSet);
+    HotKeys::Record(_key);
+    encode(args, _stored);
+    out = storage.Put(_key, _stored) ? "STORED" : "NOT_STORED";
 }
 
 } // namespace Execute
@@ -0,0 +1,31 @@
+#include <afina/execute/Snapshot.h>
+
+#include <mutex>
+
+namespace Afina {
+namespace Execute {
+
+// Handler set by the server, guarded since it is replaced on start and stop while workers run commands
+static std::mutex handler_mutex;
+static Snapshot::Handler handler;
+
+// See Snapshot.h
+void Snapshot::SetHandler(const Handler &h) {
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    handler = h;
+}
+
+// See Snapshot.h
+void Snapshot::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    if (!handler) {
+        out.assign("SERVER_ERROR snapshot is not configured");
+    } else if (!handler()) {
+        out.assign("SERVER_ERROR snapshot failed");
+    } else {
+        out.assign("OK");
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
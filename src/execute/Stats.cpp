@@ -1,14 +1,130 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Latency.h>
 #include <afina/execute/Stats.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#include <sys/resource.h>
+#include <unistd.h>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+// Server start time, uptime is counted from it
+static const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+// Formats timeval the way memcached does: seconds.microseconds
+static std::string format_time(const timeval &tv) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%ld.%06ld", long(tv.tv_sec), long(tv.tv_usec));
+    return buffer;
+}
+
+// memcached protocol: each statistic is sent as "STAT <name> <value>\r\n", list ends with "END"
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    if (_group.empty()) {
+        general(storage, stats);
+    } else if (_group == "latency") {
+        latency(stats);
+    } else if (_group == "hotkeys") {
+        hotkeys(stats);
+    } else {
+        out = "ERROR";
+        return;
+    }
+
+    out.clear();
+    for (auto &stat : stats) {
+        out += "STAT " + stat.first + " " + stat.second + "\r\n";
+    }
+    out += "END"; // networking layer should add the last \r\n
+}
+
+// See Stats.h
+void Stats::general(Storage &storage, std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("pid", std::to_string(getpid()));
+    stats.emplace_back("uptime", std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                                                    std::chrono::steady_clock::now() - started)
+                                                    .count()));
+    stats.emplace_back("time", std::to_string(std::time(nullptr)));
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.emplace_back("rusage_user", format_time(usage.ru_utime));
+        stats.emplace_back("rusage_system", format_time(usage.ru_stime));
+    }
+
+    // Counters are kept per thread and summed up only here
+    int64_t counters[Counters::Count];
+    std::size_t threads = Counters::Collect(counters);
+    for (int i = 0; i < Counters::Count; i++) {
+        stats.emplace_back(Counters::Name(Counters::Counter(i)), std::to_string(counters[i]));
+    }
+    stats.emplace_back("threads", std::to_string(threads));
+
+    storage.Stats(stats);
+}
+
+// See Stats.h
+void Stats::latency(std::vector<std::pair<std::string, std::string>> &stats) {
+    static const std::pair<const char *, double> percentiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+
+    Latency::Snapshot snapshot;
+    for (int op = 0; op < Latency::OpCount; op++) {
+        for (int phase = 0; phase < Latency::PhaseCount; phase++) {
+            Latency::Collect(Latency::Op(op), Latency::Phase(phase), snapshot);
+            if (snapshot.total == 0) {
+                continue;
+            }
+
+            std::string prefix = std::string(Latency::Name(Latency::Op(op))) + ":" +
+                                 Latency::Name(Latency::Phase(phase)) + ":";
+            stats.emplace_back(prefix + "count", std::to_string(snapshot.total));
+            for (auto &p : percentiles) {
+                stats.emplace_back(prefix + p.first, std::to_string(snapshot.Percentile(p.second)));
+            }
+            stats.emplace_back(prefix + "max", std::to_string(snapshot.max));
+        }
+    }
+}
+
+// Names stat line of the hot key, key is hex encoded unless it could be written into the line as is
+static std::string hotkey_name(const std::string &key) {
+    bool printable = true;
+    for (char c : key) {
+        unsigned char u = c;
+        printable = printable && u > ' ' && u < 0x7f;
+    }
+    if (printable) {
+        return "key:" + key;
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    std::string name = "keyhex:";
+    for (char c : key) {
+        unsigned char u = c;
+        name.push_back(digits[u >> 4]);
+        name.push_back(digits[u & 0xf]);
+    }
+    return name;
+}
+
+// See Stats.h
+void Stats::hotkeys(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("sampling", std::to_string(HotKeys::Sampling()));
+
+    std::vector<HotKeys::Entry> top;
+    HotKeys::Collect(HotKeys::Capacity, top);
+    for (auto &entry : top) {
+        stats.emplace_back(hotkey_name(entry.key), std::to_string(entry.count));
+    }
+}
 
 } // namespace Execute
 } // namespace Afina
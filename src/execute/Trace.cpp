@@ -0,0 +1,134 @@
+#include <afina/execute/Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+static_assert(sizeof(Trace::Event) == 64, "Trace event must take exactly one cache line");
+
+std::atomic<bool> Trace::_enabled(false);
+
+// Single producer, single consumer ring: owner thread writes events, drainer reads them
+struct trace_ring {
+    static constexpr std::size_t Capacity = 1024;
+
+    Trace::Event events[Capacity];
+
+    // Next event to be written, changed by owner only
+    std::atomic<uint64_t> head{0};
+
+    // Next event to be read, changed by drainer only
+    std::atomic<uint64_t> tail{0};
+
+    std::atomic<uint64_t> dropped{0};
+
+    // Ring stays registered after thread exit until drainer empties it
+    std::atomic<bool> owner_alive{true};
+
+    uint32_t thread;
+};
+
+// All rings ever created and not drained completely after their thread exit
+static std::mutex registry_mutex;
+static std::vector<std::shared_ptr<trace_ring>> registry;
+static uint32_t next_thread = 0;
+
+// Registers ring on the first event of the thread and marks it orphan on thread exit
+struct trace_ring_owner {
+    std::shared_ptr<trace_ring> ring;
+
+    trace_ring_owner() : ring(std::make_shared<trace_ring>()) {
+        std::unique_lock<std::mutex> lock(registry_mutex);
+        ring->thread = next_thread++;
+        registry.push_back(ring);
+    }
+
+    ~trace_ring_owner() { ring->owner_alive.store(false, std::memory_order_release); }
+};
+
+// See Trace.h
+void Trace::record(Op op, std::string_view key, std::size_t size) {
+    thread_local trace_ring_owner owner;
+    trace_ring &ring = *owner.ring;
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == trace_ring::Capacity) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event &event = ring.events[head % trace_ring::Capacity];
+    event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+    event.size = uint32_t(std::min<std::size_t>(size, UINT32_MAX));
+    event.thread = ring.thread;
+    event.op = op;
+    event.key_size = uint8_t(std::min(key.size(), KeySize));
+    std::memcpy(event.key, key.data(), event.key_size);
+
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+// See Trace.h
+std::size_t Trace::Drain(const std::function<void(const Event &)> &consumer, std::size_t &dropped) {
+    std::size_t drained = 0;
+    dropped = 0;
+
+    std::unique_lock<std::mutex> lock(registry_mutex);
+    for (auto it = registry.begin(); it != registry.end();) {
+        trace_ring &ring = **it;
+        bool alive = ring.owner_alive.load(std::memory_order_acquire);
+
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        for (; tail != head; tail++, drained++) {
+            consumer(ring.events[tail % trace_ring::Capacity]);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+        dropped += ring.dropped.exchange(0, std::memory_order_relaxed);
+
+        // Owner can't write anything once it is gone, so empty orphan ring could be released
+        if (!alive) {
+            it = registry.erase(it);
+        } else {
+            it++;
+        }
+    }
+    return drained;
+}
+
+// See Trace.h
+const char *Trace::Name(uint8_t op) {
+    switch (op) {
+    case opGet:
+        return "get";
+    case opSet:
+        return "set";
+    case opAdd:
+        return "add";
+    case opAppend:
+        return "append";
+    case opReplace:
+        return "replace";
+    case opCas:
+        return "cas";
+    case opIncr:
+        return "incr";
+    case opDecr:
+        return "decr";
+    case opPrepend:
+        return "prepend";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
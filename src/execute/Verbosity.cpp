@@ -0,0 +1,23 @@
+#include <afina/execute/Trace.h>
+#include <afina/execute/Verbosity.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Verbosity.h
+void Verbosity::Assign(const std::vector<std::string_view> &tokens) {
+    _level = 0;
+    for (char c : tokens[0]) {
+        _level = _level * 10 + (c - '0');
+    }
+    _noreply = (tokens.size() > 1);
+}
+
+// See Verbosity.h
+void Verbosity::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Trace::Enable(_level > 0);
+    out.assign(_noreply ? "" : "OK");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -3,25 +3,43 @@
 #include <memory>
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <semaphore.h>
 #include <signal.h>
+#include <sys/socket.h>
 #include <thread>
+#include <unistd.h>
 
 #include <cxxopts.hpp>
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Snapshot.h>
+#include <afina/execute/Trace.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
 #include "logging/ServiceImpl.h"
+#include "network/Handoff.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/LoadingStorage.h"
+#include "storage/ReadMostlyLRU.h"
+#include "storage/SegmentedLRU.h"
+#include "storage/ShardedStorage.h"
+#include "storage/SlabLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/Snapshotter.h"
+#include "storage/SimpleClock.h"
 #include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeClock.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TinyLFU.h"
 
 using namespace Afina;
 
@@ -42,22 +60,128 @@ public:
         logger.level = Logging::Logger::Level::WARNING;
         logger.appenders.push_back("console");
         logger.format = "[%H:%M:%S %z] [thread %t] [%n] [%l] %v";
+
+        // Command trace, enabled by "verbosity 1" command
+        Logging::Logger &trace = logConfig->loggers["trace"];
+        trace.level = Logging::Logger::Level::INFO;
+        trace.appenders.push_back("console");
+        trace.format = "[%H:%M:%S %z] [%n] %v";
         logService.reset(new Logging::ServiceImpl(logConfig));
 
-        // Step 1: configure storage
+        // Hot keys are sampled one out of that many accesses, 0 switches detection off
+        if (options.count("hotkeys-sampling") > 0) {
+            int sampling = options["hotkeys-sampling"].as<int>();
+            if (sampling < 0) {
+                throw std::runtime_error("Hot keys sampling must not be negative");
+            }
+            Execute::HotKeys::SetSampling(sampling);
+        }
+
+        // Step 1: configure storage, items take up to memory bytes like with memcached -m
+        std::size_t memory = std::size_t(64) << 20;
+        if (options.count("memory") > 0) {
+            int megabytes = options["memory"].as<int>();
+            if (megabytes <= 0) {
+                throw std::runtime_error("Memory limit must be positive");
+            }
+            memory = std::size_t(megabytes) << 20;
+        }
+
+        // Admission sketch needs a counter per item, items are assumed to take about that many bytes
+        const std::size_t expected_item_size = 256;
+        std::shared_ptr<Afina::Backend::AdmissionPolicy> admission;
+        if (options.count("admission") > 0) {
+            std::string admission_type = options["admission"].as<std::string>();
+            if (admission_type == "tinylfu") {
+                admission = std::make_shared<Afina::Backend::TinyLFU>(memory / expected_item_size);
+            } else if (admission_type != "none") {
+                throw std::runtime_error("Unknown admission policy");
+            }
+        }
+
         std::string storage_type = "st_lru";
         if (options.count("storage") > 0) {
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Only slab storage keeps its data in a single segment, which could be shared memory outliving the process
+        std::string segment;
+        if (options.count("segment") > 0) {
+            segment = segmentName = options["segment"].as<std::string>();
+            if (storage_type != "mt_slab") {
+                throw std::runtime_error("Shared memory segment is supported by mt_slab storage only");
+            }
+            if (options.count("snapshot") > 0) {
+                throw std::runtime_error("Snapshots can't be taken of the shared memory segment");
+            }
+        }
+
+        // Graceful restart: running process hands its listening socket over and stops. Its shared memory segment could
+        // be attached only once it has exited, its last snapshot is loaded once it has been written, see LoadSnapshot
+        if (options.count("handoff") > 0) {
+            handoffPath = options["handoff"].as<std::string>();
+            std::vector<int> sockets;
+            previousProcess = Afina::Network::Handoff::Receive(handoffPath, sockets);
+            if (previousProcess != -1) {
+                listenSocket = sockets[0];
+                for (std::size_t i = 1; i < sockets.size(); i++) {
+                    close(sockets[i]);
+                }
+            }
+            if (previousProcess != -1 && !segment.empty()) {
+                Afina::Network::Handoff::WaitClosed(previousProcess);
+                close(previousProcess);
+                previousProcess = -1;
+            }
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(memory, admission);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(memory, admission);
+        } else if (storage_type == "rm_lru") {
+            storage = std::make_shared<Afina::Backend::ReadMostlyLRU>(memory, admission);
+        } else if (storage_type == "st_clock") {
+            storage = std::make_shared<Afina::Backend::SimpleClock>(memory, false, admission);
+        } else if (storage_type == "mt_clock") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeClock>(memory, false, admission);
+        } else if (storage_type == "mt_clock_pro") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeClock>(memory, true, admission);
+        } else if (storage_type == "mt_slru") {
+            storage = std::make_shared<Afina::Backend::SegmentedLRU>(memory, admission);
+        } else if (storage_type == "mt_slab") {
+            // Pages are of 1 MB like in memcached, so the largest item could take that much
+            auto slab = std::make_shared<Afina::Backend::SlabLRU>(memory, 1024 * 1024, admission, segment);
+            segmentAttached = slab->Attached();
+            storage = slab;
+        } else if (storage_type == "mt_sharded") {
+            // Memory is split between shards evenly, each thread could keep replicas of up to 64 hot keys
+            const std::size_t shards = 16;
+            storage = std::make_shared<Afina::Backend::ShardedStorage>(
+                shards,
+                [admission, memory, shards](std::size_t) {
+                    return std::unique_ptr<Afina::Storage>(
+                        new Afina::Backend::ThreadSafeSimplLRU(memory / shards, admission));
+                },
+                64);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Clients are served while the rest of the snapshot is loaded, so keys they write or delete must not be
+        // brought back by it
+        loadFraction = 1.0;
+        if (options.count("snapshot") > 0 && options.count("snapshot-load-fraction") > 0) {
+            loadFraction = options["snapshot-load-fraction"].as<double>();
+            if (loadFraction < 0.0 || loadFraction > 1.0) {
+                throw std::runtime_error("Snapshot load fraction must be in [0, 1]");
+            }
+        }
+        if (options.count("snapshot") > 0 && loadFraction < 1.0) {
+            loadingStorage = std::make_shared<Afina::Backend::LoadingStorage>(storage);
+            storage = loadingStorage;
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -75,6 +199,44 @@ public:
         } else {
             throw std::runtime_error("Unknown network type");
         }
+
+        // Near cache of get responses in each network worker, works only with storages which track key versions
+        if (options.count("near-cache") > 0) {
+            int entries = options["near-cache"].as<int>();
+            if (entries < 0) {
+                throw std::runtime_error("Near cache size must not be negative");
+            }
+            server->SetNearCache(entries);
+        }
+
+        if (listenSocket != -1) {
+            server->SetListenSocket(listenSocket);
+        }
+
+        // Step 3: storage is filled from the snapshot on start, snapshots are taken on "snapshot" command, SIGUSR1,
+        // periodically and on stop
+        if (options.count("snapshot") > 0) {
+            snapshotPath = options["snapshot"].as<std::string>();
+
+            int interval = 0;
+            if (options.count("snapshot-interval") > 0) {
+                interval = options["snapshot-interval"].as<int>();
+                if (interval < 0) {
+                    throw std::runtime_error("Snapshot interval must not be negative");
+                }
+            }
+
+            auto log = logService;
+            snapshotter = std::make_shared<Afina::Backend::Snapshotter>(
+                storage, snapshotPath, std::chrono::seconds(interval),
+                [log](bool ok, std::chrono::milliseconds duration) {
+                    if (ok) {
+                        log->select("root")->warn("Snapshot written in {} ms", duration.count());
+                    } else {
+                        log->select("root")->error("Snapshot failed after {} ms", duration.count());
+                    }
+                });
+        }
     }
 
     // Start services in correct order
@@ -83,37 +245,243 @@ public:
         auto log = logService->select("root");
         log->warn("Start afina server {}", Afina::get_version());
 
+        traceStopped = false;
+        traceDrainer = std::thread(&Application::DrainTrace, this);
+
         log->warn("Start storage");
+        if (segmentAttached) {
+            log->warn("Storage has attached to the items left in shared memory {}", segmentName);
+        } else if (!segmentName.empty()) {
+            // Layout of the segment depends on -m, so items of the process with other limit are dropped too
+            log->warn("Shared memory {} starts empty, next process must have the same memory limit to attach",
+                      segmentName);
+        }
         storage->Start();
 
+        // Previous process has to be waited for only to load its last snapshot
+        if (listenSocket != -1) {
+            log->warn("Listening socket has been taken over from the running process");
+        }
+        if (previousProcess != -1 && !snapshotter) {
+            close(previousProcess);
+            previousProcess = -1;
+        }
+
+        // Network starts once enough of the snapshot is loaded, the rest is loaded while serving requests
+        if (snapshotter) {
+            log->warn("Load snapshot {}", snapshotPath);
+            loadReady = loadStopped = snapshotsStarted = false;
+            snapshotLoader = std::thread(&Application::LoadSnapshot, this);
+
+            std::unique_lock<std::mutex> lock(loadMutex);
+            loadProgress.wait(lock, [this] { return loadReady; });
+        }
+
         // TODO: configure network service
         const uint16_t port = 8080;
         log->warn("Start network on {}", port);
         server->Start(port, 2, 2);
+
+        if (!handoffPath.empty()) {
+            log->warn("Wait for the next process on {}", handoffPath);
+            handoffListener = Afina::Network::Handoff::Listen(handoffPath);
+            handoffServer = std::thread(&Application::ServeHandoff, this);
+        }
     }
 
     // Stop services in correct order
     void Stop() {
         auto log = logService->select("root");
         log->warn("Stop application");
+        if (handoffListener != -1) {
+            shutdown(handoffListener, SHUT_RDWR);
+            handoffServer.join();
+            close(handoffListener);
+
+            // Socket path belongs to the next process once it has connected
+            if (nextProcess == -1) {
+                unlink(handoffPath.c_str());
+            }
+        }
+
         server->Stop();
         server->Join();
 
+        // Nothing changes storage anymore, so the last snapshot has everything. Unless snapshot hasn't been loaded
+        // completely yet: storage has only part of the items then, so the old snapshot is kept
+        if (snapshotter) {
+            {
+                std::unique_lock<std::mutex> lock(loadMutex);
+                loadStopped = true;
+            }
+            if (previousProcess != -1) {
+                shutdown(previousProcess, SHUT_RDWR);
+            }
+            snapshotLoader.join();
+            if (previousProcess != -1) {
+                close(previousProcess);
+                previousProcess = -1;
+            }
+
+            if (snapshotsStarted) {
+                Execute::Snapshot::SetHandler(Execute::Snapshot::Handler());
+                snapshotter->Stop();
+                snapshotter->Take();
+            }
+        }
+
         storage->Stop();
+
+        {
+            std::unique_lock<std::mutex> lock(traceMutex);
+            traceStopped = true;
+        }
+        traceStop.notify_all();
+        traceDrainer.join();
         logService->Stop();
     }
 
+    // Asks for snapshot in background, if snapshots are configured
+    void Snapshot() {
+        if (snapshotter) {
+            snapshotter->Request();
+        }
+    }
+
 private:
+    // Fills storage from the snapshot, then starts taking snapshots
+    void LoadSnapshot() {
+        auto log = logService->select("root");
+        if (previousProcess != -1) {
+            log->warn("Wait for the previous process to write its last snapshot");
+            Afina::Network::Handoff::WaitClosed(previousProcess);
+        }
+        auto started = std::chrono::steady_clock::now();
+
+        std::size_t items;
+        bool loaded = Afina::Backend::Snapshot::Load(
+            *storage, snapshotPath, std::max(1u, std::thread::hardware_concurrency()), items,
+            [this](std::size_t loaded, std::size_t total) {
+                std::unique_lock<std::mutex> lock(loadMutex);
+                if (!loadReady && loaded >= loadFraction * total) {
+                    loadReady = true;
+                    loadProgress.notify_all();
+                }
+                return !loadStopped;
+            });
+        if (loadingStorage) {
+            loadingStorage->Loaded();
+        }
+
+        std::unique_lock<std::mutex> lock(loadMutex);
+        loadReady = true;
+        loadProgress.notify_all();
+        if (loadStopped) {
+            log->warn("Snapshot loading is interrupted");
+            return;
+        }
+
+        auto duration = std::chrono::steady_clock::now() - started;
+        if (loaded) {
+            log->warn("Snapshot loaded: {} items in {} ms", items,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+        } else {
+            log->error("Snapshot {} can't be loaded, starting with empty storage", snapshotPath);
+        }
+
+        log->warn("Start snapshots");
+        snapshotter->Start();
+        auto s = snapshotter;
+        Execute::Snapshot::SetHandler([s]() {
+            s->Request();
+            return true;
+        });
+        snapshotsStarted = true;
+    }
+
+    // Hands listening socket over to the next process once it connects, then stops this one the same way as SIGTERM
+    // does. Connection to the next process is left open, kernel closes it once this process exits
+    void ServeHandoff() {
+        auto log = logService->select("root");
+        while (true) {
+            int next = accept4(handoffListener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (next == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+
+            if (!Afina::Network::Handoff::Send(next, {server->ListenSocket()})) {
+                log->error("Failed to hand listening socket over to the next process");
+                close(next);
+                continue;
+            }
+            log->warn("Listening socket has been handed over to the next process");
+            nextProcess = next;
+            kill(getpid(), SIGTERM);
+            return;
+        }
+    }
+
+    // Periodically moves command trace events into the log, until Stop
+    void DrainTrace() {
+        auto log = logService->select("trace");
+        std::unique_lock<std::mutex> lock(traceMutex);
+        bool stop = false;
+        while (!stop) {
+            stop = traceStop.wait_for(lock, std::chrono::milliseconds(100), [this] { return traceStopped; });
+
+            std::size_t dropped;
+            Execute::Trace::Drain(
+                [&log](const Execute::Trace::Event &e) {
+                    log->info("{}.{:09d} thread={} {} key={} size={}", e.time / 1000000000, e.time % 1000000000,
+                              e.thread, Execute::Trace::Name(e.op), std::string(e.key, e.key_size), e.size);
+                },
+                dropped);
+            if (dropped > 0) {
+                log->warn("{} trace events dropped", dropped);
+            }
+        }
+    }
+
     std::shared_ptr<Afina::Logging::Config> logConfig;
     std::shared_ptr<Afina::Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
+    std::shared_ptr<Afina::Backend::LoadingStorage> loadingStorage;
     std::shared_ptr<Afina::Network::Server> server;
+    std::string segmentName;
+    bool segmentAttached = false;
+    std::shared_ptr<Afina::Backend::Snapshotter> snapshotter;
+    std::string snapshotPath;
+    double loadFraction;
+
+    std::thread snapshotLoader;
+    std::mutex loadMutex;
+    std::condition_variable loadProgress;
+    bool loadReady;
+    bool loadStopped;
+    bool snapshotsStarted;
+
+    // Graceful restart, see Network::Handoff
+    std::string handoffPath;
+    int listenSocket = -1;
+    int previousProcess = -1;
+    int nextProcess = -1;
+    int handoffListener = -1;
+    std::thread handoffServer;
+
+    std::thread traceDrainer;
+    std::mutex traceMutex;
+    std::condition_variable traceStop;
+    bool traceStopped;
 };
 
 // Signal set that to notify application about time to stop
 sem_t stop_semaphore;
 volatile sig_atomic_t stop_reason = 0;
+volatile sig_atomic_t snapshot_signal = 0;
 
 // Catch user desire to stop the server
 void on_term(int signum, siginfo_t *siginfo, void *data) {
@@ -121,6 +489,12 @@ void on_term(int signum, siginfo_t *siginfo, void *data) {
     sem_post(&stop_semaphore);
 }
 
+// Catch user desire to snapshot the storage, it is taken by the main thread
+void on_snapshot(int signum, siginfo_t *siginfo, void *data) {
+    snapshot_signal = 1;
+    sem_post(&stop_semaphore);
+}
+
 int main(int argc, char **argv) {
     // Command line arguments parsing
     cxxopts::Options options("afina", "Simple memory caching server");
@@ -129,6 +503,23 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Memory limit for items in megabytes, 64 by default", cxxopts::value<int>());
+        options.add_options()("a,admission", "Admission policy for the storage", cxxopts::value<std::string>());
+        options.add_options()("hotkeys-sampling", "Sample one out of that many accesses to detect hot keys, 0 to disable",
+                              cxxopts::value<int>());
+        options.add_options()("near-cache", "Number of hot keys each network worker caches get responses for",
+                              cxxopts::value<int>());
+        options.add_options()("segment",
+                              "Name of the shared memory to keep mt_slab items in across restarts, sized by --memory",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot", "File to snapshot storage into", cxxopts::value<std::string>());
+        options.add_options()("snapshot-load-fraction",
+                              "Fraction of the snapshot to load before accepting connections, 0 to load in background",
+                              cxxopts::value<double>());
+        options.add_options()("snapshot-interval", "Seconds between periodic snapshots, 0 to disable",
+                              cxxopts::value<int>());
+        options.add_options()("handoff", "Unix socket to take listening socket over from the running process at",
+                              cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -161,6 +552,9 @@ int main(int argc, char **argv) {
 
         sigaction(SIGINT, &act, NULL);
         sigaction(SIGTERM, &act, NULL);
+
+        act.sa_sigaction = on_snapshot;
+        sigaction(SIGUSR1, &act, NULL);
     }
 
     // Run app
@@ -168,9 +562,15 @@ int main(int argc, char **argv) {
         // Start services
         app.Start();
 
-        // Freeze main thread until one of signals arrive
-        while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
-            continue;
+        // Freeze main thread until one of stop signals arrive, serving snapshot requests meanwhile
+        while (stop_reason == 0) {
+            if (sem_wait(&stop_semaphore) == -1 && errno == EINTR) {
+                continue;
+            }
+            if (snapshot_signal) {
+                snapshot_signal = 0;
+                app.Snapshot();
+            }
         }
 
         // Stop services
@@ -0,0 +1,150 @@
+#include "Handoff.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+constexpr std::size_t Handoff::MaxSockets;
+
+// Fills Unix socket address, throws if path doesn't fit
+static sockaddr_un unix_address(const std::string &path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid handoff socket path " + path);
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return addr;
+}
+
+// See Handoff.h
+int Handoff::Listen(const std::string &path) {
+    sockaddr_un addr = unix_address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open handoff socket: " + std::string(std::strerror(errno)));
+    }
+
+    // Previous process doesn't remove its socket once it has handed over, so the path is reused
+    unlink(path.c_str());
+    mode_t mask = umask(077);
+    int bound = bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    umask(mask);
+    if (bound == -1 || listen(fd, 1) == -1) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Failed to listen on handoff socket " + path + ": " + std::strerror(error));
+    }
+    return fd;
+}
+
+// See Handoff.h
+bool Handoff::Send(int connection, const std::vector<int> &sockets) {
+    if (sockets.empty() || sockets.size() > MaxSockets) {
+        return false;
+    }
+
+    // At least one byte of data must go along with the descriptors
+    char tag = 'S';
+    iovec iov = {&tag, sizeof(tag)};
+    alignas(cmsghdr) char control[CMSG_SPACE(MaxSockets * sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sockets.size() * sizeof(int));
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sockets.size() * sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), sockets.data(), sockets.size() * sizeof(int));
+
+    ssize_t sent;
+    while ((sent = sendmsg(connection, &msg, MSG_NOSIGNAL)) == -1 && errno == EINTR) {
+    }
+    return sent == sizeof(tag);
+}
+
+// See Handoff.h
+int Handoff::Receive(const std::string &path, std::vector<int> &sockets) {
+    sockets.clear();
+    sockaddr_un addr = unix_address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open handoff socket: " + std::string(std::strerror(errno)));
+    }
+
+    // Missing or stale socket means there is no running process, so there is nothing to take over
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1) {
+        int error = errno;
+        close(fd);
+        if (error == ENOENT || error == ECONNREFUSED) {
+            return -1;
+        }
+        throw std::runtime_error("Failed to connect to handoff socket " + path + ": " + std::strerror(error));
+    }
+
+    if (!Receive(fd, sockets)) {
+        close(fd);
+        throw std::runtime_error("Running process hasn't handed its sockets over");
+    }
+    return fd;
+}
+
+// See Handoff.h
+bool Handoff::Receive(int connection, std::vector<int> &sockets) {
+    sockets.clear();
+    char tag;
+    iovec iov = {&tag, sizeof(tag)};
+    alignas(cmsghdr) char control[CMSG_SPACE(MaxSockets * sizeof(int))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    while ((received = recvmsg(connection, &msg, MSG_CMSG_CLOEXEC)) == -1 && errno == EINTR) {
+    }
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); received > 0 && cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            sockets.resize(count);
+            std::memcpy(sockets.data(), CMSG_DATA(cmsg), count * sizeof(int));
+        }
+    }
+
+    if (received != sizeof(tag) || sockets.empty() || (msg.msg_flags & MSG_CTRUNC)) {
+        for (int socket : sockets) {
+            close(socket);
+        }
+        sockets.clear();
+        return false;
+    }
+    return true;
+}
+
+// See Handoff.h
+void Handoff::WaitClosed(int connection) {
+    char buffer[64];
+    ssize_t got;
+    while ((got = read(connection, buffer, sizeof(buffer))) > 0 || (got == -1 && errno == EINTR)) {
+    }
+}
+
+} // namespace Network
+} // namespace Afina
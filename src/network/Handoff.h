@@ -0,0 +1,71 @@
+#ifndef AFINA_NETWORK_HANDOFF_H
+#define AFINA_NETWORK_HANDOFF_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Listening sockets handoff
+ * Graceful restart protocol between the running process and the new one, over Unix socket at well known path. Running
+ * process listens there, new process connects and gets the listening sockets via SCM_RIGHTS, so both processes
+ * share the same sockets and connections are never refused. Once sockets are sent, the old process stops accepting,
+ * drains its connections and exits; the connection is closed by the kernel then, so the new process knows the old
+ * one is gone, e.g. has written its last snapshot or has detached from the shared memory.
+ *
+ * Only whoever could connect to the path could take sockets over, so the path is accessible by the owner only
+ */
+class Handoff {
+public:
+    /**
+     * Opens Unix socket to wait for the new process on, stale socket of the previous process is replaced. Throws
+     * std::runtime_error if socket can't be opened
+     *
+     * @param path of the Unix socket
+     */
+    static int Listen(const std::string &path);
+
+    /**
+     * Sends sockets to the new process, connection stays open. Returns false if sockets can't be sent
+     *
+     * @param connection to the new process
+     * @param sockets to hand over
+     */
+    static bool Send(int connection, const std::vector<int> &sockets);
+
+    /**
+     * Connects to the running process and takes its sockets over. Returns connection to the process, or -1 if there
+     * is no process listening at the path. Throws std::runtime_error if process doesn't hand sockets over
+     *
+     * @param path of the Unix socket
+     * @param sockets output parameter, sockets received
+     */
+    static int Receive(const std::string &path, std::vector<int> &sockets);
+
+    /**
+     * Takes sockets sent over the connection established already. Returns false, leaving nothing open, if there
+     * are no sockets in the message or the connection is closed
+     *
+     * @param connection to the process sending sockets
+     * @param sockets output parameter, sockets received
+     */
+    static bool Receive(int connection, std::vector<int> &sockets);
+
+    /**
+     * Blocks until the process on the other end exits, or connection is shut down locally
+     *
+     * @param connection returned by Receive
+     */
+    static void WaitClosed(int connection);
+
+    // Maximum number of sockets handed over at once
+    static constexpr std::size_t MaxSockets = 16;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_HANDOFF_H
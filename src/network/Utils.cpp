@@ -0,0 +1,34 @@
+#include "Utils.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+#include <afina/execute/Response.h>
+
+namespace Afina {
+namespace Network {
+
+// See Utils.h
+void send_response(int socket, const Execute::Response &response, std::vector<iovec> &iov) {
+    response.Iovecs(iov);
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        ssize_t sent = writev(socket, iov.data() + first, std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        if (sent <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+
+        // Skip iovecs sent completely and move the start of the partially sent one
+        for (; first < iov.size() && std::size_t(sent) >= iov[first].iov_len; first++) {
+            sent -= iov[first].iov_len;
+        }
+        if (sent > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + sent;
+            iov[first].iov_len -= sent;
+        }
+    }
+}
+
+} // namespace Network
+} // namespace Afina
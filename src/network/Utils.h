@@ -0,0 +1,28 @@
+#ifndef AFINA_NETWORK_UTILS_H
+#define AFINA_NETWORK_UTILS_H
+
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Execute {
+class Response;
+} // namespace Execute
+
+namespace Network {
+
+/**
+ * Sends the whole response to the blocking socket, writev could send only part of it. Throws std::runtime_error
+ * if socket fails
+ *
+ * @param socket to write to
+ * @param response to be sent
+ * @param iov scratch buffer for iovecs, reused between calls
+ */
+void send_response(int socket, const Execute::Response &response, std::vector<iovec> &iov);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_UTILS_H
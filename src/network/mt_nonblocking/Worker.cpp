@@ -11,6 +11,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/execute/NearCache.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -21,8 +22,9 @@ namespace Network {
 namespace MTnonblock {
 
 // See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               std::size_t near_cache)
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _near_cache_size(near_cache) {
     // TODO: implementation here
 }
 
@@ -41,6 +43,8 @@ Worker &Worker::operator=(Worker &&other) {
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _near_cache_size = other._near_cache_size;
+    _near_cache = std::move(other._near_cache);
 
     other._epoll_fd = -1;
     return *this;
@@ -52,6 +56,9 @@ void Worker::Start(int epoll_fd) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
         _logger = _pLogging->select("network.worker");
+        if (_near_cache_size > 0) {
+            _near_cache.reset(new Afina::Execute::NearCache(_near_cache_size));
+        }
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
@@ -2,6 +2,7 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_WORKER_H
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <thread>
 
@@ -13,6 +14,9 @@ namespace Afina {
 
 // Forward declaration, see afina/Storage.h
 class Storage;
+namespace Execute {
+class NearCache;
+}
 namespace Logging {
 class Service;
 }
@@ -27,7 +31,11 @@ namespace MTnonblock {
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    /**
+     * @param near_cache number of hot keys worker keeps get responses for, 0 if there is no near cache
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::size_t near_cache = 0);
     ~Worker();
 
     Worker(Worker &&);
@@ -81,6 +89,12 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Size of the near cache to be created on Start
+    std::size_t _near_cache_size;
+
+    // Get responses of hot keys, shared by all connections of the worker: their parsers get it on creation
+    std::unique_ptr<Afina::Execute::NearCache> _near_cache;
 };
 
 } // namespace MTnonblock
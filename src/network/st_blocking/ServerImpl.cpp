@@ -1,5 +1,6 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -7,26 +8,39 @@
 #include <stdexcept>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/Latency.h>
+#include <afina/execute/NearCache.h>
+#include <afina/execute/Response.h>
 #include <afina/logging/Service.h>
 
+#include "protocol/BinaryParser.h"
 #include "protocol/Parser.h"
 
+#include "../Utils.h"
+
 namespace Afina {
 namespace Network {
 namespace STblocking {
 
+using Execute::Latency;
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -48,57 +62,75 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // For IPv4 we use struct sockaddr_in:
-    // struct sockaddr_in {
-    //     short int          sin_family;  // Address family, AF_INET
-    //     unsigned short int sin_port;    // Port number
-    //     struct in_addr     sin_addr;    // Internet address
-    //     unsigned char      sin_zero[8]; // Same size as struct sockaddr
-    // };
-    //
-    // Note we need to convert the port to network order
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    // Arguments are:
-    // - Family: IPv4
-    // - Type: Full-duplex stream (reliable)
-    // - Protocol: TCP
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
+    if (listenSocket != -1) {
+        // Socket is bound and listening already, see Server::SetListenSocket
+        _server_socket = listenSocket;
+    } else {
+        // For IPv4 we use struct sockaddr_in:
+        // struct sockaddr_in {
+        //     short int          sin_family;  // Address family, AF_INET
+        //     unsigned short int sin_port;    // Port number
+        //     struct in_addr     sin_addr;    // Internet address
+        //     unsigned char      sin_zero[8]; // Same size as struct sockaddr
+        // };
+        //
+        // Note we need to convert the port to network order
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        // Arguments are:
+        // - Family: IPv4
+        // - Type: Full-duplex stream (reliable)
+        // - Protocol: TCP
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket");
+        }
+
+        // when the server closes the socket,the connection must stay in the TIME_WAIT state to
+        // make sure the client received the acknowledgement that the connection has been terminated.
+        // During this time, this port is unavailable to other processes, unless we specify this option
+        //
+        // This option let kernel knows that we are OK that multiple threads/processes are listen on the
+        // same port. In a such case kernel will balance input traffic between all listeners (except those who
+        // are closed already)
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed");
+        }
+
+        // Bind the socket to the address. In other words let kernel know data for what address we'd
+        // like to see in the socket
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed");
+        }
 
-    // when the server closes the socket,the connection must stay in the TIME_WAIT state to
-    // make sure the client received the acknowledgement that the connection has been terminated.
-    // During this time, this port is unavailable to other processes, unless we specify this option
-    //
-    // This option let kernel knows that we are OK that multiple threads/processes are listen on the
-    // same port. In a such case kernel will balance input traffic between all listeners (except those who
-    // are closed already)
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
+        // Start listening. The second parameter is the "backlog", or the maximum number of
+        // connections that we'll allow to queue up. Note that listen() doesn't block until
+        // incoming connections arrive. It just makesthe OS aware that this process is willing
+        // to accept connections on this socket (which is bound to a specific IP and port)
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed");
+        }
     }
+    listenSocket = _server_socket;
 
-    // Bind the socket to the address. In other words let kernel know data for what address we'd
-    // like to see in the socket
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
+    // Socket could be shared with another process, e.g. during graceful restart, which might accept the connection
+    // first, so acceptor waits in poll() and accept() must not block
+    int flags = fcntl(_server_socket, F_GETFL, 0);
+    if (flags == -1 || fcntl(_server_socket, F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw std::runtime_error("Failed to make socket non blocking");
     }
 
-    // Start listening. The second parameter is the "backlog", or the maximum number of
-    // connections that we'll allow to queue up. Note that listen() doesn't block until
-    // incoming connections arrive. It just makesthe OS aware that this process is willing
-    // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
+    _event_fd = eventfd(0, EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event descriptor");
     }
 
     running.store(true);
@@ -108,7 +140,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+
+    // Listening socket isn't shut down, it might be listening in the next process already
+    eventfd_write(_event_fd, 1);
 }
 
 // See Server.h
@@ -116,6 +150,7 @@ void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
     close(_server_socket);
+    close(_event_fd);
 }
 
 // See Server.h
@@ -125,20 +160,44 @@ void ServerImpl::OnRun() {
     // - command_to_execute: last command parsed out of stream
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
+    // - result: buffer for the binary protocol responses, reused between commands
+    // - response, iov: text command response and iovecs to send it, reused between commands
+    // - binary_parser: parser for the binary protocol connections, detected by the first byte
+    // - near_cache: get responses of hot keys, the only thread serves all connections so it is shared by them
     std::size_t arg_remains;
+    std::unique_ptr<Execute::NearCache> near_cache;
+    if (nearCacheSize > 0) {
+        near_cache.reset(new Execute::NearCache(nearCacheSize));
+    }
     Protocol::Parser parser;
+    parser.UseNearCache(near_cache.get());
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Execute::Command *command_to_execute = nullptr;
+    Latency::Op command_op = Latency::opOther;
+    std::string result;
+    Execute::Response response;
+    std::vector<iovec> iov;
+    Protocol::BinaryParser binary_parser;
+    bool protocol_detected = false, binary_protocol = false;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
-        // The call to accept() blocks until the incoming connection arrives
+        // Wait until the incoming connection arrives or Stop wakes the thread up. Once stopped, connections are left
+        // in the queue for whoever else listens on the socket
+        struct pollfd fds[2] = {{_server_socket, POLLIN, 0}, {_event_fd, POLLIN, 0}};
+        if (poll(fds, 2, -1) == -1 || !(fds[0].revents & POLLIN) || !running.load()) {
+            continue;
+        }
+
+        // Connection could have been accepted by another process sharing the socket, accept() fails then
         int client_socket;
         struct sockaddr client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
         if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
             continue;
         }
+        Execute::Counters::Add(Execute::Counters::totalConnections);
+        Execute::Counters::Add(Execute::Counters::currConnections);
 
         // Got new connection
         if (_logger->should_log(spdlog::level::debug)) {
@@ -168,25 +227,67 @@ void ServerImpl::OnRun() {
         try {
             int readed_bytes = -1;
             char client_buffer[4096];
-            while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+
+            // Input not processed yet is in [buffer_begin, buffer_end). Parsed commands might point into the buffer,
+            // so it is compacted only once all complete commands in it are executed
+            std::size_t buffer_begin = 0, buffer_end = 0;
+            while ((readed_bytes =
+                        read(client_socket, client_buffer + buffer_end, sizeof(client_buffer) - buffer_end)) > 0) {
                 _logger->debug("Got {} bytes from socket", readed_bytes);
+                buffer_end += readed_bytes;
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
                 // - read#0: [<command1 start>]
                 // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-                while (readed_bytes > 0) {
-                    _logger->debug("Process {} bytes", readed_bytes);
+                while (buffer_begin < buffer_end) {
+                    _logger->debug("Process {} bytes", buffer_end - buffer_begin);
+
+                    // Protocol is detected once by the first byte of the connection
+                    if (!protocol_detected) {
+                        binary_protocol =
+                            (uint8_t(client_buffer[buffer_begin]) == Protocol::BinaryParser::RequestMagic);
+                        protocol_detected = true;
+                    }
+
+                    // Binary requests are executed by parser right away, it consumes the whole input
+                    if (binary_protocol) {
+                        result.clear();
+                        buffer_begin += binary_parser.Process(*pStorage, client_buffer + buffer_begin,
+                                                              buffer_end - buffer_begin, result);
+                        if (!result.empty() && send(client_socket, result.data(), result.size(), 0) <= 0) {
+                            throw std::runtime_error("Failed to send response");
+                        }
+                        if (binary_parser.Failed()) {
+                            throw std::runtime_error("Malformed binary request");
+                        }
+                        continue;
+                    }
+
                     // There is no command yet
                     if (!command_to_execute) {
                         std::size_t parsed = 0;
-                        if (parser.Parse(client_buffer, readed_bytes, parsed)) {
-                            // There is no command to be launched, continue to parse input stream
-                            // Here we are, current chunk finished some command, process it
-                            _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                            command_to_execute = parser.Build(arg_remains);
-                            if (arg_remains > 0) {
-                                arg_remains += 2;
+                        uint64_t parse_start = Latency::Now();
+                        if (parser.Parse(client_buffer + buffer_begin, buffer_end - buffer_begin, parsed)) {
+                            if (!parser.Error().empty()) {
+                                // Malformed line has been skipped by parser already, report it and go on with
+                                // the next one
+                                _logger->debug("Malformed command in {} bytes", parsed);
+                                if (send(client_socket, parser.Error().data(), parser.Error().size(), 0) <= 0) {
+                                    throw std::runtime_error("Failed to send response");
+                                }
+                                parser.Reset();
+                            } else {
+                                // There is no command to be launched, continue to parse input stream
+                                // Here we are, current chunk finished some command, process it
+                                _logger->debug("Found new command: {} in {} bytes", std::string(parser.Name()),
+                                               parsed);
+                                command_to_execute = parser.Build(arg_remains);
+                                command_op = Latency::OpOf(parser.Name());
+                                Latency::Record(command_op, Latency::phParse, Latency::Now() - parse_start);
+                                if (arg_remains > 0) {
+                                    arg_remains += 2;
+                                }
                             }
                         }
 
@@ -195,42 +296,59 @@ void ServerImpl::OnRun() {
                         if (parsed == 0) {
                             break;
                         } else {
-                            std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
-                            readed_bytes -= parsed;
+                            buffer_begin += parsed;
                         }
                     }
 
                     // There is command, but we still wait for argument to arrive...
                     if (command_to_execute && arg_remains > 0) {
-                        _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
+                        _logger->debug("Fill argument: {} bytes of {}", buffer_end - buffer_begin, arg_remains);
                         // There is some parsed command, and now we are reading argument
-                        std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-                        argument_for_command.append(client_buffer, to_read);
+                        std::size_t to_read = std::min(arg_remains, buffer_end - buffer_begin);
+                        argument_for_command.append(client_buffer + buffer_begin, to_read);
 
-                        std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                        buffer_begin += to_read;
                         arg_remains -= to_read;
-                        readed_bytes -= to_read;
                     }
 
                     // Thre is command & argument - RUN!
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
-                        command_to_execute->Execute(*pStorage, argument_for_command, result);
-
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
+                        // Data block is followed by \r\n, it isn't a part of the value. Like memcached, the command is
+                        // dropped if the terminator is something else
+                        if (!argument_for_command.empty() && !Protocol::Parser::StripDataBlock(argument_for_command)) {
+                            _logger->debug("Bad data chunk of {} bytes", argument_for_command.size());
+                            const std::string_view &error = Protocol::Parser::BadDataChunk;
+                            if (send(client_socket, error.data(), error.size(), 0) <= 0) {
+                                throw std::runtime_error("Failed to send response");
+                            }
+                        } else {
+                            response.Clear();
+                            uint64_t started = Latency::Now();
+                            command_to_execute->Execute(*pStorage, argument_for_command, response);
+                            uint64_t executed = Latency::Now();
+                            Latency::Record(command_op, Latency::phStorage, executed - started);
+
+                            // Send response, quiet commands could have nothing to say
+                            if (!response.Empty()) {
+                                response.Append("\r\n");
+                                send_response(client_socket, response, iov);
+                                Latency::Record(command_op, Latency::phWrite, Latency::Now() - executed);
+                            }
                         }
 
                         // Prepare for the next command
-                        command_to_execute.reset();
+                        command_to_execute = nullptr;
                         argument_for_command.resize(0);
                         parser.Reset();
                     }
-                } // while (readed_bytes)
+                } // while (buffer_begin < buffer_end)
+
+                // Commands waiting for the argument own their keys, so nothing points into the buffer now
+                std::memmove(client_buffer, client_buffer + buffer_begin, buffer_end - buffer_begin);
+                buffer_end -= buffer_begin;
+                buffer_begin = 0;
             }
 
             if (readed_bytes == 0) {
@@ -244,11 +362,14 @@ void ServerImpl::OnRun() {
 
         // We are done with this connection
         close(client_socket);
+        Execute::Counters::Add(Execute::Counters::currConnections, -1);
 
         // Prepare for the next command: just in case if connection was closed in the middle of executing something
-        command_to_execute.reset();
+        command_to_execute = nullptr;
         argument_for_command.resize(0);
         parser.Reset();
+        binary_parser.Reset();
+        protocol_detected = false;
     }
 
     // Cleanup on exit...
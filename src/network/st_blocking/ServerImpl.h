@@ -50,6 +50,9 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
+    // Event to wake the acceptor thread up on Stop
+    int _event_fd;
+
     // Thread to run network on
     std::thread _thread;
 };
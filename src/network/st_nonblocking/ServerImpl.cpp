@@ -46,34 +46,41 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
+    if (listenSocket != -1) {
+        // Socket is bound and listening already, see Server::SetListenSocket
+        _server_socket = listenSocket;
+        make_socket_non_blocking(_server_socket);
+    } else {
+        // Create server socket
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        make_socket_non_blocking(_server_socket);
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
     }
+    listenSocket = _server_socket;
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
@@ -0,0 +1,325 @@
+#include "BinaryParser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <endian.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Item.h>
+
+namespace Afina {
+namespace Protocol {
+
+using Execute::Counters;
+using Execute::HotKeys;
+using Execute::Item;
+
+// Magic byte of every response
+static constexpr uint8_t response_magic = 0x81;
+
+// Biggest packet body accepted, anything larger is considered as broken stream
+static constexpr uint32_t max_body_length = 2 * 1024 * 1024;
+
+enum Opcode : uint8_t {
+    opGet = 0x00,
+    opSet = 0x01,
+    opAdd = 0x02,
+    opReplace = 0x03,
+    opDelete = 0x04,
+    opGetQ = 0x09,
+    opNoop = 0x0a,
+    opGetK = 0x0c,
+    opGetKQ = 0x0d,
+    opAppend = 0x0e,
+    opPrepend = 0x0f,
+    opSetQ = 0x11,
+    opAddQ = 0x12,
+    opReplaceQ = 0x13,
+    opDeleteQ = 0x14,
+    opAppendQ = 0x19,
+    opPrependQ = 0x1a
+};
+
+enum Status : uint16_t {
+    stOk = 0x0000,
+    stKeyNotFound = 0x0001,
+    stKeyExists = 0x0002,
+    stInvalidArguments = 0x0004,
+    stNotStored = 0x0005,
+    stUnknownCommand = 0x0081
+};
+
+// See BinaryParser.h
+void BinaryParser::Reset() {
+    _pending.clear();
+    _failed = false;
+}
+
+// See BinaryParser.h
+bool BinaryParser::read_header(const char *packet, header &h) {
+    std::memcpy(&h, packet, sizeof(header));
+    h.key_length = be16toh(h.key_length);
+    h.status = be16toh(h.status);
+    h.body_length = be32toh(h.body_length);
+    h.cas = be64toh(h.cas);
+    return h.magic == RequestMagic && h.body_length <= max_body_length;
+}
+
+// See BinaryParser.h
+std::size_t BinaryParser::Process(Storage &storage, const char *input, const std::size_t size, std::string &out) {
+    std::size_t consumed = 0;
+    header h;
+    while (consumed < size && !_failed) {
+        const char *data = input + consumed;
+        std::size_t available = size - consumed;
+
+        // Fast path: whole packet is in the input, execute it in place
+        if (_pending.empty() && available >= sizeof(header)) {
+            if (!read_header(data, h)) {
+                _failed = true;
+                break;
+            }
+
+            std::size_t packet_size = sizeof(header) + h.body_length;
+            if (available >= packet_size) {
+                execute(storage, data, out);
+                consumed += packet_size;
+                continue;
+            }
+        }
+
+        // Packet is split across inputs, collect it in own buffer
+        std::size_t want = sizeof(header) - std::min(sizeof(header), _pending.size());
+        if (want == 0) {
+            read_header(_pending.data(), h);
+            want = sizeof(header) + h.body_length - _pending.size();
+        }
+
+        std::size_t n = std::min(want, available);
+        _pending.append(data, n);
+        consumed += n;
+        if (_pending.size() < sizeof(header)) {
+            continue;
+        }
+
+        if (!read_header(_pending.data(), h)) {
+            _failed = true;
+            break;
+        }
+        if (_pending.size() == sizeof(header) + h.body_length) {
+            execute(storage, _pending.data(), out);
+            _pending.clear();
+        }
+    }
+    return consumed;
+}
+
+// See BinaryParser.h
+void BinaryParser::execute(Storage &storage, const char *packet, std::string &out) {
+    header h;
+    read_header(packet, h);
+
+    if (h.key_length + h.extras_length > h.body_length) {
+        respond_error(out, h, stInvalidArguments);
+        return;
+    }
+    std::size_t value_length = h.body_length - h.key_length - h.extras_length;
+
+    const char *key = packet + sizeof(header) + h.extras_length;
+    const char *value = key + h.key_length;
+
+    switch (h.opcode) {
+    case opGet:
+    case opGetQ:
+    case opGetK:
+    case opGetKQ: {
+        bool quiet = (h.opcode == opGetQ || h.opcode == opGetKQ);
+        bool with_key = (h.opcode == opGetK || h.opcode == opGetKQ);
+        if (h.extras_length != 0 || h.key_length == 0 || value_length != 0) {
+            respond_error(out, h, stInvalidArguments);
+            break;
+        }
+
+        _key.assign(key, h.key_length);
+        Item item;
+        std::string_view data;
+        bool hit = storage.Get(_key, _value) && Item::Live(&_value, Item::Now(), item, data);
+        Counters::Add(Counters::cmdGet);
+        HotKeys::Record(_key);
+        Counters::Add(hit ? Counters::getHits : Counters::getMisses);
+        if (hit) {
+            uint32_t flags = htobe32(item.flags);
+            respond(out, h, stOk, std::string_view(reinterpret_cast<const char *>(&flags), sizeof(flags)),
+                    with_key ? std::string_view(_key) : std::string_view(), data, item.cas);
+        } else if (!quiet) {
+            respond_error(out, h, stKeyNotFound);
+        }
+        break;
+    }
+
+    case opSet:
+    case opSetQ:
+    case opAdd:
+    case opAddQ:
+    case opReplace:
+    case opReplaceQ: {
+        // Extras are flags and expiration time
+        if (h.extras_length != 8 || h.key_length == 0) {
+            respond_error(out, h, stInvalidArguments);
+            break;
+        }
+
+        uint32_t flags, exptime;
+        std::memcpy(&flags, packet + sizeof(header), 4);
+        std::memcpy(&exptime, packet + sizeof(header) + 4, 4);
+
+        Counters::Add(Counters::cmdSet);
+        HotKeys::Record(std::string_view(key, h.key_length));
+        int64_t now = Item::Now();
+        Item item;
+        item.flags = be32toh(flags);
+        item.exptime = Item::ExpireAt(int32_t(be32toh(exptime)), now);
+        item.cas = Item::NextCas();
+
+        // Non zero CAS in request means that value must be replaced only if it wasn't changed since client got it
+        uint16_t status = stNotStored;
+        _key.assign(key, h.key_length);
+        bool stored = storage.Update(_key, [&](const std::string *current, std::string &updated) {
+            Item old;
+            std::string_view data;
+            bool live = Item::Live(current, now, old, data);
+            if ((h.opcode == opAdd || h.opcode == opAddQ) && live) {
+                status = stKeyExists;
+            } else if ((h.opcode == opReplace || h.opcode == opReplaceQ || h.cas != 0) && !live) {
+                status = stKeyNotFound;
+            } else if (h.cas != 0 && h.cas != old.cas) {
+                status = stKeyExists;
+            } else {
+                Item::Encode(item, std::string_view(value, value_length), updated);
+                return Storage::UpdateAction::Store;
+            }
+            return Storage::UpdateAction::Keep;
+        });
+
+        if (!stored) {
+            respond_error(out, h, status);
+        } else if (h.opcode == opSet || h.opcode == opAdd || h.opcode == opReplace) {
+            respond(out, h, stOk, std::string_view(), std::string_view(), std::string_view(), item.cas);
+        }
+        break;
+    }
+
+    case opAppend:
+    case opAppendQ:
+    case opPrepend:
+    case opPrependQ: {
+        if (h.extras_length != 0 || h.key_length == 0) {
+            respond_error(out, h, stInvalidArguments);
+            break;
+        }
+
+        // Data is added to the stored value in place, item keeps its flags and expiration time
+        Counters::Add(Counters::cmdSet);
+        HotKeys::Record(std::string_view(key, h.key_length));
+        int64_t now = Item::Now();
+        uint64_t cas = 0;
+        auto patch = [&](std::string &current) {
+            if (!Item::Live(current, now)) {
+                return false;
+            }
+            Item::SetCas(current, cas = Item::NextCas());
+            return true;
+        };
+
+        _key.assign(key, h.key_length);
+        _value.assign(value, value_length);
+        bool stored = (h.opcode == opAppend || h.opcode == opAppendQ)
+                          ? storage.Append(_key, _value, patch)
+                          : storage.Insert(_key, _value, Item::HeaderSize, patch);
+
+        if (!stored) {
+            respond_error(out, h, stNotStored);
+        } else if (h.opcode == opAppend || h.opcode == opPrepend) {
+            respond(out, h, stOk, std::string_view(), std::string_view(), std::string_view(), cas);
+        }
+        break;
+    }
+
+    case opDelete:
+    case opDeleteQ: {
+        if (h.extras_length != 0 || h.key_length == 0 || value_length != 0) {
+            respond_error(out, h, stInvalidArguments);
+            break;
+        }
+
+        // Expired item is missing for the client even though storage still has it
+        int64_t now = Item::Now();
+        _key.assign(key, h.key_length);
+        bool deleted = storage.Update(_key, [&](const std::string *current, std::string &) {
+            Item item;
+            std::string_view data;
+            return Item::Live(current, now, item, data) ? Storage::UpdateAction::Remove : Storage::UpdateAction::Keep;
+        });
+        if (!deleted) {
+            respond_error(out, h, stKeyNotFound);
+        } else if (h.opcode == opDelete) {
+            respond(out, h, stOk, std::string_view(), std::string_view(), std::string_view());
+        }
+        break;
+    }
+
+    case opNoop: {
+        respond(out, h, stOk, std::string_view(), std::string_view(), std::string_view());
+        break;
+    }
+
+    default:
+        respond_error(out, h, stUnknownCommand);
+    }
+}
+
+// See BinaryParser.h
+void BinaryParser::respond(std::string &out, const header &request, uint16_t status, std::string_view extras,
+                           std::string_view key, std::string_view value, uint64_t cas) {
+    header h;
+    h.magic = response_magic;
+    h.opcode = request.opcode;
+    h.key_length = htobe16(key.size());
+    h.extras_length = extras.size();
+    h.data_type = 0;
+    h.status = htobe16(status);
+    h.body_length = htobe32(extras.size() + key.size() + value.size());
+    h.opaque = request.opaque;
+    h.cas = htobe64(cas);
+
+    out.append(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.append(extras).append(key).append(value);
+}
+
+// See BinaryParser.h
+void BinaryParser::respond_error(std::string &out, const header &request, uint16_t status) {
+    std::string_view message;
+    switch (status) {
+    case stKeyNotFound:
+        message = "Not found";
+        break;
+    case stKeyExists:
+        message = "Data exists for key.";
+        break;
+    case stInvalidArguments:
+        message = "Invalid arguments";
+        break;
+    case stNotStored:
+        message = "Not stored.";
+        break;
+    default:
+        message = "Unknown command";
+    }
+    respond(out, request, status, std::string_view(), std::string_view(), message);
+}
+
+} // namespace Protocol
+} // namespace Afina
@@ -0,0 +1,94 @@
+#ifndef AFINA_PROTOCOL_BINARY_PARSER_H
+#define AFINA_PROTOCOL_BINARY_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Afina {
+class Storage;
+
+namespace Protocol {
+
+/**
+ * # Memcached binary protocol parser
+ * Every packet starts with the fixed 24 bytes header that tells lengths of extras, key and value following it, so
+ * no scanning of the input is needed. Parser executes requests right away and appends responses to the output.
+ *
+ * Supported operations: get, getq, getk, getkq, set, add, replace, delete, append, prepend, their quiet versions
+ * and noop. Quiet requests produce response only on error (or on miss for get), so client could pipeline batch of
+ * them and send noop to find out the batch is done.
+ *
+ * Packets split across inputs are collected in the parser own buffer
+ */
+class BinaryParser {
+public:
+    // Magic byte every request starts with
+    static constexpr uint8_t RequestMagic = 0x80;
+
+    BinaryParser() { Reset(); }
+
+    /**
+     * Executes all complete requests from the input and appends responses into out. Incomplete packet at the end of
+     * the input is copied and completed by the next calls
+     *
+     * @param storage to execute requests on
+     * @param input buffer with requests
+     * @param size number of bytes in the input buffer that could be read
+     * @param out buffer to append responses to
+     * @return number of bytes consumed from the input
+     */
+    std::size_t Process(Storage &storage, const char *input, const std::size_t size, std::string &out);
+
+    /**
+     * Returns true if input isn't binary protocol stream anymore, so that connection must be closed
+     */
+    inline bool Failed() const { return _failed; }
+
+    /**
+     * Reset parser so that it could be used for the new connection
+     */
+    void Reset();
+
+private:
+    struct header {
+        uint8_t magic;
+        uint8_t opcode;
+        uint16_t key_length;
+        uint8_t extras_length;
+        uint8_t data_type;
+        uint16_t status;
+        uint32_t body_length;
+        uint32_t opaque;
+        uint64_t cas;
+    };
+    static_assert(sizeof(header) == 24, "Binary protocol header must be 24 bytes");
+
+    // Decodes header from the network byte order, returns false if packet isn't valid request
+    bool read_header(const char *packet, header &h);
+
+    // Executes single complete packet
+    void execute(Storage &storage, const char *packet, std::string &out);
+
+    // Appends response packet for the given request
+    void respond(std::string &out, const header &request, uint16_t status, std::string_view extras,
+                 std::string_view key, std::string_view value, uint64_t cas = 0);
+
+    // Appends response with error message for the given request
+    void respond_error(std::string &out, const header &request, uint16_t status);
+
+    // Incomplete packet
+    std::string _pending;
+
+    // Buffers reused by requests
+    std::string _key;
+    std::string _value;
+
+    bool _failed;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_BINARY_PARSER_H
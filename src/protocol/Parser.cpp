@@ -1,45 +1,224 @@
 #include "Parser.h"
 
-#include <iostream>
-#include <sstream>
-#include <stdexcept>
+#include <limits>
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Arithmetic.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/MetaArithmetic.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Verbosity.h>
+
+#include "Scanner.h"
 
 namespace Afina {
 namespace Protocol {
 
+// Responses for malformed input, allocated once
+static const std::string_view error_unknown_command = "ERROR\r\n";
+static const std::string_view error_bad_format = "CLIENT_ERROR bad command line format\r\n";
+
+const std::string_view Parser::BadDataChunk = "CLIENT_ERROR bad data chunk\r\n";
+
+// Parses decimal number in [begin, end) that must fit into [min, max]
+static bool parse_number(const char *begin, const char *end, int64_t min, int64_t max, int64_t &out) {
+    bool negative = (begin != end && *begin == '-' && min < 0);
+    if (negative) {
+        begin++;
+    }
+    if (begin == end || end - begin > 10) {
+        return false;
+    }
+
+    int64_t result = 0;
+    for (const char *p = begin; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+    }
+
+    out = negative ? -result : result;
+    return out >= min && out <= max;
+}
+
+// Parses decimal 64-bit unsigned number in [begin, end)
+static bool parse_unsigned(const char *begin, const char *end, uint64_t &out) {
+    if (begin == end || end - begin > 20) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (const char *p = begin; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        uint64_t digit = *p - '0';
+        if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+
+    out = result;
+    return true;
+}
+
+// Storage commands: <key> <flags> <exptime> <bytes>, cas has <cas unique> in addition
+static bool is_storage(std::string_view name) {
+    return name == "set" || name == "add" || name == "replace" || name == "append" || name == "prepend" ||
+           name == "cas";
+}
+
+// Meta commands that take key and flags, they are tokenized the same way as get
+static bool is_meta(std::string_view name) { return name == "mg" || name == "ms" || name == "md" || name == "ma"; }
+
+// Commands that take list of space separated tokens
+static bool is_tokenized(std::string_view name) {
+    return name == "get" || name == "gets" || name == "incr" || name == "decr" || name == "verbosity" ||
+           is_meta(name);
+}
+
+// Retrieval commands, memcached answers them without a key as unknown command
+static bool is_retrieval(std::string_view name) { return name == "get" || name == "gets"; }
+
+// Commands that take no arguments, stats takes optional one
+static bool is_bare(std::string_view name) { return name == "stats" || name == "mn" || name == "snapshot"; }
+
+// Returns command owned by parser, reinitialized with given arguments
+template <typename T, typename... Args> static T *reuse(std::unique_ptr<T> &command, Args &&... args) {
+    if (!command) {
+        command.reset(new T());
+    }
+    command->Assign(std::forward<Args>(args)...);
+    return command.get();
+}
+
+// See Parse.h
+Parser::Parser() : key_count(0), near_cache(nullptr) { Reset(); }
+
+// See Parse.h
+Parser::~Parser() {}
+
+// See Parse.h
+bool Parser::parse_line(const char *input, const size_t size, size_t &parsed) {
+    const char *end = input + size;
+    const char *p = FindDelimiter(input, end);
+    if (p == end) {
+        return false;
+    }
+    name = std::string_view(input, p - input);
+
+    if (is_tokenized(name) || (name == "stats" && *p == ' ')) {
+        if (*p != ' ') {
+            return false;
+        }
+        do {
+            const char *start = p + 1;
+            p = FindDelimiter(start, end);
+            if (p == end) {
+                return false;
+            }
+            keys.emplace_back(start, p - start);
+        } while (*p == ' ');
+        if (!check_tokens()) {
+            return false;
+        }
+    } else if (is_storage(name)) {
+        // <key> <flags> <exptime> <bytes> [<cas unique>]\r, anything unusual is left for the state machine to report
+        const char *tokens[6];
+        const int count = (name == "cas") ? 6 : 5;
+        tokens[0] = p;
+        for (int i = 1; i < count; i++) {
+            if (*p != ' ') {
+                return false;
+            }
+            tokens[i] = p = FindDelimiter(p + 1, end);
+            if (p == end) {
+                return false;
+            }
+        }
+        if (*p != '\r') {
+            return false;
+        }
+
+        int64_t f, et, b;
+        if (!parse_number(tokens[1] + 1, tokens[2], 0, std::numeric_limits<uint32_t>::max(), f) ||
+            !parse_number(tokens[2] + 1, tokens[3], std::numeric_limits<int32_t>::min(),
+                          std::numeric_limits<int32_t>::max(), et) ||
+            !parse_number(tokens[3] + 1, tokens[4], 0, std::numeric_limits<uint32_t>::max(), b) ||
+            (count == 6 && !parse_unsigned(tokens[4] + 1, tokens[5], number))) {
+            return false;
+        }
+
+        keys.emplace_back(tokens[0] + 1, tokens[1] - tokens[0] - 1);
+        flags = f;
+        exprtime = et;
+        bytes = b;
+    } else if (!is_bare(name) || *p != '\r') {
+        return false;
+    }
+
+    if (p + 1 == end || p[1] != '\n') {
+        return false;
+    }
+
+    state = State::sLF;
+    parse_complete = true;
+    parsed = p + 2 - input;
+    return true;
+}
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
     size_t pos;
     parsed = 0;
 
+    // Whole line is in the buffer: split it onto tokens at once, byte by byte parsing is used only for commands
+    // split across reads or malformed ones
+    if (state == State::sName && name_buffer.empty()) {
+        if (parse_line(input, size, parsed)) {
+            return true;
+        }
+        Reset();
+    }
+
     for (pos = 0; pos < size && !parse_complete; pos++) {
         char c = input[pos];
-        // std::cout << "[" << pos << "] '" << c << "': state=" << int(state) << std::endl;
 
         switch (state) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
-                // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                name = name_buffer;
+                if (is_storage(name)) {
                     state = State::spKey;
-                } else if (name == "get" || name == "gets") {
-                    state = State::sgKey;
-                } else if (name == "stats") {
+                } else if (is_tokenized(name) || (name == "stats" && c == ' ')) {
+                    // At least one key is required
+                    if (c == ' ') {
+                        state = State::sgKey;
+                    } else {
+                        fail(is_retrieval(name) ? error_unknown_command : error_bad_format);
+                    }
+                } else if (is_bare(name)) {
                     state = State::sLF;
                     continue;
                 } else {
-                    throw std::runtime_error("Unknown command name: " + name);
+                    fail(error_unknown_command);
                 }
             } else {
-                name.push_back(c);
+                name_buffer.push_back(c);
             }
             break;
         }
@@ -47,32 +226,25 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
+                push_key();
             } else {
-                curKey.push_back(c);
+                cur_key().push_back(c);
             }
             break;
         }
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
-
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
-                }
-
-                curKey.clear();
+                push_key();
                 state = State::sLF;
+                if (!check_tokens()) {
+                    fail(is_retrieval(name) ? error_unknown_command : error_bad_format);
+                }
             } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
                 state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
+                push_key();
             } else {
-                curKey.push_back(c);
+                cur_key().push_back(c);
             }
             break;
         }
@@ -81,12 +253,12 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             if (c == ' ') {
                 negative = false;
                 state = State::spExprTimeStart;
-                // std::cout << "parser debug: flags='" << flags << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
                 uint32_t f = (flags * 10) + (c - '0');
                 if (f < flags) {
                     // Overflow
-                    throw std::runtime_error("Flags field overflow");
+                    fail(error_bad_format);
+                    break;
                 }
                 flags = f;
             }
@@ -107,19 +279,11 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spExprTime: {
             if (c == ' ') {
                 state = State::spBytes;
-                // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
-                if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
+                int64_t et = int64_t(exprtime) * 10 + (negative ? -(c - '0') : (c - '0'));
+                if (et > std::numeric_limits<int32_t>::max() || et < std::numeric_limits<int32_t>::min()) {
+                    fail(error_bad_format);
+                    break;
                 }
                 exprtime = et;
             }
@@ -127,33 +291,60 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         }
 
         case State::spBytes: {
-            if (c == '\r') {
+            if (c == ' ' && name == "cas") {
+                state = State::spCas;
+            } else if (c == '\r') {
+                if (name == "cas") {
+                    // CAS unique is mandatory
+                    fail(error_bad_format);
+                    break;
+                }
                 state = State::sLF;
-                // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
                 uint32_t b = (bytes * 10) + (c - '0');
                 if (b < bytes) {
                     // Overflow
-                    throw std::runtime_error("Bytes field overflow");
+                    fail(error_bad_format);
+                    break;
                 }
                 bytes = b;
             }
             break;
         }
 
+        case State::spCas: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t digit = c - '0';
+                if (number > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                    // Overflow
+                    fail(error_bad_format);
+                    break;
+                }
+                number = number * 10 + digit;
+            }
+            break;
+        }
+
         case State::sLF: {
             if (c == '\n') {
                 parse_complete = true;
             } else {
-                std::stringstream err;
-                err << "Invalid char " << (int)c << " at position " << (parsed + pos) << ", \\n expected";
-                throw std::runtime_error(err.str());
+                fail(error_bad_format);
+            }
+            break;
+        }
+
+        case State::sSkip: {
+            if (c == '\n') {
+                parse_complete = true;
             }
             break;
         }
 
         default:
-            throw std::runtime_error("Unknown state");
+            fail(error_bad_format);
         }
     }
 
@@ -162,37 +353,132 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 }
 
 // See Parse.h
-std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
+void Parser::push_key() {
+    keys.emplace_back(cur_key());
+    key_count++;
+}
+
+// See Parse.h
+bool Parser::check_tokens() {
+    if (is_retrieval(name)) {
+        // get <key>*, every key is checked as empty one would be looked up otherwise
+        if (keys.empty()) {
+            return false;
+        }
+        for (auto &key : keys) {
+            if (key.empty()) {
+                return false;
+            }
+        }
+        return true;
+    } else if (keys.empty() || keys[0].empty()) {
+        return false;
+    } else if (name == "incr" || name == "decr") {
+        // incr <key> <value>
+        return keys.size() == 2 && parse_unsigned(keys[1].data(), keys[1].data() + keys[1].size(), number);
+    } else if (name == "verbosity") {
+        // verbosity <level> [noreply]
+        int64_t level;
+        return (keys.size() == 1 || (keys.size() == 2 && keys[1] == "noreply")) &&
+               parse_number(keys[0].data(), keys[0].data() + keys[0].size(), 0, std::numeric_limits<int32_t>::max(),
+                            level);
+    } else if (name != "ms") {
+        return true;
+    }
+
+    int64_t b;
+    if (keys.size() < 2 || !parse_number(keys[1].data(), keys[1].data() + keys[1].size(), 0,
+                                         std::numeric_limits<uint32_t>::max(), b)) {
+        return false;
+    }
+    bytes = b;
+    return true;
+}
+
+// See Parse.h
+void Parser::fail(std::string_view message) {
+    error = message;
+    state = State::sSkip;
+}
+
+// See Parse.h
+Execute::Command *Parser::Build(size_t &body_size) {
     if (state != State::sLF) {
-        return std::unique_ptr<Execute::Command>(nullptr);
+        return nullptr;
     }
 
     body_size = bytes;
     if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
+        return reuse(set_command, keys[0], flags, exprtime);
     } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
+        return reuse(add_command, keys[0], flags, exprtime);
+    } else if (name == "replace") {
+        return reuse(replace_command, keys[0], flags, exprtime);
     } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+        return reuse(append_command, keys[0], flags, exprtime);
+    } else if (name == "prepend") {
+        return reuse(prepend_command, keys[0], flags, exprtime);
+    } else if (name == "cas") {
+        return reuse(cas_command, keys[0], flags, exprtime, number);
+    } else if (name == "get" || name == "gets") {
+        return reuse(get_command, keys, name == "gets", near_cache);
+    } else if (name == "incr" || name == "decr") {
+        return reuse(arithmetic_command, keys[0], number, name == "decr");
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        // Optional token selects group of statistics
+        return reuse(stats_command, keys);
+    } else if (name == "mg") {
+        return reuse(meta_get_command, keys);
+    } else if (name == "ms") {
+        // Data length token is followed by flags
+        return reuse(meta_set_command, keys, 2);
+    } else if (name == "md") {
+        return reuse(meta_delete_command, keys);
+    } else if (name == "ma") {
+        return reuse(meta_arithmetic_command, keys);
+    } else if (name == "verbosity") {
+        return reuse(verbosity_command, keys);
+    } else if (name == "mn") {
+        if (!meta_noop_command) {
+            meta_noop_command.reset(new Execute::MetaNoop());
+        }
+        return meta_noop_command.get();
+    } else if (name == "snapshot") {
+        if (!snapshot_command) {
+            snapshot_command.reset(new Execute::Snapshot());
+        }
+        return snapshot_command.get();
     } else {
-        throw std::runtime_error("Unsupported command");
+        return nullptr;
+    }
+}
+
+// See Parser.h
+bool Parser::StripDataBlock(std::string &block) {
+    std::size_t size = block.size();
+    if (size < 2 || block[size - 2] != '\r' || block[size - 1] != '\n') {
+        return false;
     }
+    block.resize(size - 2);
+    return true;
 }
 
 // See Parse.h
 void Parser::Reset() {
     state = State::sName;
-    name.clear();
+    name = std::string_view();
+    name_buffer.clear();
     keys.clear();
-    curKey.clear();
+    for (size_t i = 0; i <= key_count && i < key_buffers.size(); i++) {
+        key_buffers[i].clear();
+    }
+    key_count = 0;
     parse_complete = false;
+    error = std::string_view();
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    number = 0;
 }
 
 } // namespace Protocol
@@ -1,8 +1,10 @@
 #ifndef AFINA_PROTOCOL_PARSER_H
 #define AFINA_PROTOCOL_PARSER_H
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <cstddef>
@@ -11,16 +13,42 @@
 namespace Afina {
 namespace Execute {
 class Command;
+class Set;
+class Add;
+class Replace;
+class Append;
+class Prepend;
+class Cas;
+class Get;
+class Arithmetic;
+class Stats;
+class MetaGet;
+class MetaSet;
+class MetaDelete;
+class MetaArithmetic;
+class MetaNoop;
+class Verbosity;
+class Snapshot;
+class NearCache;
 } // namespace Execute
 namespace Protocol {
 
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Parser doesn't copy command name and keys if the whole command line is in the input, they are views into the
+ * input buffer. So caller must keep buffer untouched until the command built out of it is executed. If command is
+ * split across several inputs then it is accumulated in the parser own buffers, which are reused by next commands.
+ * In both cases views stay valid until Reset
+ *
+ * Malformed input never throws: parser skips the rest of the line and reports it as parsed, Error then returns
+ * response for the client
  */
 class Parser {
 public:
-    Parser() { Reset(); }
+    Parser();
+    ~Parser();
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -31,6 +59,9 @@ public:
      */
     bool Parse(const std::string &input, size_t &parsed) { return Parse(&input[0], input.size(), parsed); }
 
+    // Parsed command could point into the input, so it must not be a temporary
+    bool Parse(std::string &&input, size_t &parsed) = delete;
+
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -44,32 +75,82 @@ public:
 
     /**
      * Builds new command from parsed input. In case if it wasn't enough input to prse command out
-     * method return nullptr
+     * or input was malformed method return nullptr
+     *
+     * Command is owned by parser and the same object is returned by next Build of the same command type, so it is
+     * valid until next Build call
      */
-    std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
+    Execute::Command *Build(size_t &body_size);
 
     /**
      * Reset parse so that it could be used to parse out new command
      */
     void Reset();
 
-    inline const std::string &Name() const { return name; }
+    inline std::string_view Name() const { return name; }
+
+    /**
+     * Makes get commands use near cache of the network worker, nullptr switches it off. Cache must outlive parser
+     */
+    inline void UseNearCache(Execute::NearCache *cache) { near_cache = cache; }
+
+    /**
+     * Returns response line, including \r\n, to be sent for malformed command or empty string if there is no error.
+     * Points to static memory, so it is valid after Reset
+     */
+    inline std::string_view Error() const { return error; }
+
+    /**
+     * Removes \r\n terminating data block of the storage command. Returns false if block isn't terminated by \r\n,
+     * BadDataChunk is the response for the client then
+     *
+     * @param block data block read as body_size + 2 bytes
+     */
+    static bool StripDataBlock(std::string &block);
+
+    // Response line for the data block that isn't terminated properly
+    static const std::string_view BadDataChunk;
 
 private:
+    /**
+     * Fast path: parses command if input holds it completely, delimiters are found by SIMD scanner. Returns false
+     * and leaves parser in unspecified state if line is incomplete or doesn't look like a valid command
+     */
+    bool parse_line(const char *input, const size_t size, size_t &parsed);
+
+    // Buffer for the key state machine is accumulating now
+    inline std::string &cur_key() {
+        if (key_count == key_buffers.size()) {
+            key_buffers.emplace_back();
+        }
+        return key_buffers[key_count];
+    }
+
+    // Finishes key accumulated by state machine
+    void push_key();
+
+    // Validates tokens of meta, incr/decr and verbosity commands, ms data length and incr/decr value are parsed out
+    // of them. Returns false if line is malformed
+    bool check_tokens();
+
+    // Reports error and skips input until the end of line
+    void fail(std::string_view message);
+
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * - sp: for PUT commands only, spCas is for the last token of CAS
+     * - sg: for commands taking list of tokens: GET, meta, verbosity and STATS with arguments
+     * - sSkip: malformed line is skipped until \n
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, spCas, sgKey, sSkip };
 
     // Current parser state
     State state;
 
     // vrious fields of the command
-    std::string name;
-    std::vector<std::string> keys;
+    std::string_view name;
+    std::vector<std::string_view> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -88,9 +169,40 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> of CAS command or <value> of INCR/DECR, 64-bit unsigned
+    uint64_t number;
+
     bool negative;
-    std::string curKey;
     bool parse_complete;
+
+    // Response for the malformed command, empty if there is no error
+    std::string_view error;
+
+    // Storage for the command split across inputs. Deque never moves its elements, so views on them stay valid
+    std::string name_buffer;
+    std::deque<std::string> key_buffers;
+    std::size_t key_count;
+
+    // Near cache of the worker serving the connection, if any
+    Execute::NearCache *near_cache;
+
+    // Commands reused by Build, created on first use
+    std::unique_ptr<Execute::Set> set_command;
+    std::unique_ptr<Execute::Add> add_command;
+    std::unique_ptr<Execute::Replace> replace_command;
+    std::unique_ptr<Execute::Append> append_command;
+    std::unique_ptr<Execute::Prepend> prepend_command;
+    std::unique_ptr<Execute::Cas> cas_command;
+    std::unique_ptr<Execute::Get> get_command;
+    std::unique_ptr<Execute::Arithmetic> arithmetic_command;
+    std::unique_ptr<Execute::Stats> stats_command;
+    std::unique_ptr<Execute::MetaGet> meta_get_command;
+    std::unique_ptr<Execute::MetaSet> meta_set_command;
+    std::unique_ptr<Execute::MetaDelete> meta_delete_command;
+    std::unique_ptr<Execute::MetaArithmetic> meta_arithmetic_command;
+    std::unique_ptr<Execute::MetaNoop> meta_noop_command;
+    std::unique_ptr<Execute::Verbosity> verbosity_command;
+    std::unique_ptr<Execute::Snapshot> snapshot_command;
 };
 
 } // namespace Protocol
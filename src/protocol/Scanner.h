@@ -0,0 +1,61 @@
+#ifndef AFINA_PROTOCOL_SCANNER_H
+#define AFINA_PROTOCOL_SCANNER_H
+
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Afina {
+namespace Protocol {
+
+/**
+ * # Delimiter scanner
+ * Finds first token delimiter of memcached text protocol, that is ' ' or '\r', in [begin, end). Returns end if
+ * there is no delimiter.
+ *
+ * Checks 32 bytes at once if AVX2 is available, 16 bytes with SSE2 and falls back to plain loop otherwise. Loads
+ * are unaligned and never cross end of the range, the tail is checked byte by byte.
+ */
+inline const char *FindDelimiter(const char *begin, const char *end) {
+    const char *p = begin;
+
+#if defined(__AVX2__)
+    const __m256i space32 = _mm256_set1_epi8(' ');
+    const __m256i cr32 = _mm256_set1_epi8('\r');
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space32), _mm256_cmpeq_epi8(chunk, cr32));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i space16 = _mm_set1_epi8(' ');
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, space16), _mm_cmpeq_epi8(chunk, cr16));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; p < end; p++) {
+        if (*p == ' ' || *p == '\r') {
+            return p;
+        }
+    }
+    return end;
+}
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_SCANNER_H
@@ -0,0 +1,35 @@
+#ifndef AFINA_STORAGE_ADMISSION_POLICY_H
+#define AFINA_STORAGE_ADMISSION_POLICY_H
+
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Cache admission filter
+ * Storage backend consults policy each time new key requires some other one to be evicted. Policy could
+ * reject new key, in a such case storage keeps victim and doesn't store new one.
+ *
+ * Record could be called concurrently from many threads, Admit is called only under the storage exclusive lock
+ */
+class AdmissionPolicy {
+public:
+    AdmissionPolicy() {}
+    virtual ~AdmissionPolicy() {}
+
+    /**
+     * Notifies policy that key has been accessed, regardless if it was hit or miss
+     */
+    virtual void Record(const std::string &key) = 0;
+
+    /**
+     * Returns true if candidate key worth to evict the victim
+     */
+    virtual bool Admit(const std::string &candidate, const std::string &victim) = 0;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ADMISSION_POLICY_H
@@ -0,0 +1,56 @@
+#include "LoadingStorage.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t LoadingStorage::Stripes;
+
+// See LoadingStorage.h
+LoadingStorage::LoadingStorage(std::shared_ptr<Storage> storage)
+    : _storage(storage), _loading(true), _stripes(new stripe[Stripes]) {}
+
+// See LoadingStorage.h
+void LoadingStorage::Loaded() {
+    _loading.store(false, std::memory_order_release);
+    for (std::size_t i = 0; i < Stripes; i++) {
+        std::unique_lock<std::mutex> lock(_stripes[i].mutex);
+        std::unordered_set<std::string>().swap(_stripes[i].keys);
+    }
+}
+
+// See LoadingStorage.h
+void LoadingStorage::remember(const std::string &key) {
+    stripe &s = stripe_of(key);
+    std::unique_lock<std::mutex> lock(s.mutex);
+
+    // Loading could have been finished while writer was on its way here, then nobody would ever free the key
+    if (_loading.load(std::memory_order_relaxed)) {
+        s.keys.insert(key);
+    }
+}
+
+// See LoadingStorage.h
+bool LoadingStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (!_loading.load(std::memory_order_acquire)) {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Written keys are checked under the lock of the wrapped storage, so client write of the key either has been
+    // remembered already or comes after the item is stored and overrides it
+    return _storage->Update(key, [&](const std::string *current, std::string &updated) {
+        if (current != nullptr) {
+            return UpdateAction::Keep;
+        }
+
+        stripe &s = stripe_of(key);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        if (s.keys.count(key) != 0) {
+            return UpdateAction::Keep;
+        }
+        updated = value;
+        return UpdateAction::Store;
+    });
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,156 @@
+#ifndef AFINA_STORAGE_LOADING_STORAGE_H
+#define AFINA_STORAGE_LOADING_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage served while snapshot is loaded
+ * Wraps storage clients work with while the rest of the snapshot is loaded in background. Snapshot items are
+ * stored by PutIfAbsent, which alone would bring back the key client has deleted, or has written and then lost to
+ * eviction, before loader reached it. So until Loaded is called every key clients write or delete is remembered,
+ * and PutIfAbsent treats such key as present. Check and store happen in one Update of the wrapped storage, and key
+ * is remembered before the write starts, so snapshot item either lands before the client write or isn't stored.
+ *
+ * Keys are kept in striped sets, so writers of different keys rarely share a lock. Once loading is done each write
+ * costs one more atomic load, everything else is forwarded as is
+ */
+class LoadingStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to wrap, keys written to it are remembered right away
+     */
+    LoadingStorage(std::shared_ptr<Storage> storage);
+    ~LoadingStorage() {}
+
+    /**
+     * Stops remembering written keys and frees them, PutIfAbsent is plain one from now on
+     */
+    void Loaded();
+
+    // Starts wrapped storage
+    void Start() override { _storage->Start(); }
+
+    // Stops wrapped storage
+    void Stop() override { _storage->Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override {
+        written(key);
+        return _storage->Put(key, value);
+    }
+
+    // Stores snapshot item unless key is present or has been written by clients since loading started
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override {
+        written(key);
+        return _storage->Set(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override {
+        written(key);
+        return _storage->Delete(key);
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &update) override {
+        written(key);
+        return _storage->Update(key, update);
+    }
+
+    // Implements Afina::Storage interface
+    bool Add(const std::string &key, const std::string &value, const Check &present) override {
+        written(key);
+        return _storage->Add(key, value, present);
+    }
+
+    // Implements Afina::Storage interface
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override {
+        written(key);
+        return _storage->Replace(key, value, present);
+    }
+
+    // Implements Afina::Storage interface
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override {
+        written(key);
+        return _storage->Insert(key, data, offset, patch);
+    }
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override {
+        _storage->MultiGet(keys, values, found);
+    }
+
+    // Implements Afina::Storage interface
+    uint64_t Version(std::string_view key) override { return _storage->Version(key); }
+
+    // Implements Afina::Storage interface
+    bool OnEvict(const Evicted &evicted) override { return _storage->OnEvict(evicted); }
+
+    // Implements Afina::Storage interface
+    void Touch(const std::string &key) override { _storage->Touch(key); }
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &frozen) override { _storage->Freeze(frozen); }
+
+    // Implements Afina::Storage interface
+    bool Scan(const Visitor &visit) override { return _storage->Scan(visit); }
+
+    // Implements Afina::Storage interface
+    std::size_t Partitions() override { return _storage->Partitions(); }
+
+    // Implements Afina::Storage interface
+    std::size_t Partition(std::string_view key) override { return _storage->Partition(key); }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override { _storage->Stats(stats); }
+
+private:
+    // Number of independently locked sets of written keys
+    static constexpr std::size_t Stripes = 64;
+
+    struct stripe {
+        std::mutex mutex;
+        std::unordered_set<std::string> keys;
+    };
+
+    inline stripe &stripe_of(const std::string &key) { return _stripes[std::hash<std::string>()(key) % Stripes]; }
+
+    // Remembers key before client writes it, if snapshot is still being loaded
+    inline void written(const std::string &key) {
+        if (_loading.load(std::memory_order_acquire)) {
+            remember(key);
+        }
+    }
+
+    void remember(const std::string &key);
+
+    std::shared_ptr<Storage> _storage;
+
+    std::atomic<bool> _loading;
+    std::unique_ptr<stripe[]> _stripes;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOADING_STORAGE_H
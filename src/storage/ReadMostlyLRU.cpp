@@ -0,0 +1,133 @@
+#include "ReadMostlyLRU.h"
+
+#include <mutex>
+
+namespace Afina {
+namespace Backend {
+
+// See ReadMostlyLRU.h
+void ReadMostlyLRU::drain_reads() {
+    _reads.for_each([this](read_buffer &reads) {
+        for (std::size_t i = 0; i < reads.size; i++) {
+            lru_node &node = *reads.nodes[i];
+            // Same node could be recorded by many threads, move it only once
+            if (_clock - node.stamp >= _lru_index.size() / 4) {
+                move_to_tail(node);
+            }
+        }
+        reads.size = 0;
+    });
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Put(const std::string &key, const std::string &value) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Put(key, value);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::PutIfAbsent(key, value);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Set(const std::string &key, const std::string &value) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Set(key, value);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Delete(const std::string &key) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Delete(key);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Update(const std::string &key, const Updater &update) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Update(key, update);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Add(const std::string &key, const std::string &value, const Check &present) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Add(key, value, present);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Replace(const std::string &key, const std::string &value, const Check &present) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Replace(key, value, present);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    return SimpleLRU::Insert(key, data, offset, patch);
+}
+
+// See ReadMostlyLRU.h
+void ReadMostlyLRU::Freeze(const std::function<void()> &frozen) {
+    // Recorded promotions are applied first, so that scan sees recency order readers have observed
+    std::unique_lock<std::shared_mutex> lock(_m);
+    drain_reads();
+    frozen();
+}
+
+// See ReadMostlyLRU.h
+void ReadMostlyLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::shared_lock<std::shared_mutex> lock(_m);
+    SimpleLRU::Stats(stats);
+}
+
+// See ReadMostlyLRU.h
+bool ReadMostlyLRU::Get(const std::string &key, std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    bool buffer_full = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(_m);
+        auto it = _lru_index.find(key);
+        if (it == _lru_index.end()) {
+            return false;
+        }
+
+        lru_node &node = it->second.get();
+        value = node.value;
+
+        // Node is in the freshest quarter of the list already, promotion won't change much
+        if (_clock - node.stamp < _lru_index.size() / 4) {
+            return true;
+        }
+
+        // Pointer must be recorded under the lock: writer drains buffers before it could delete any node
+        read_buffer &reads = _reads.get();
+        if (reads.size < reads.nodes.size()) {
+            reads.nodes[reads.size++] = &node;
+        }
+        buffer_full = (reads.size == reads.nodes.size());
+    }
+
+    // Buffer is full, apply promotions unless someone else is holding the lock
+    if (buffer_full) {
+        std::unique_lock<std::shared_mutex> lock(_m, std::try_to_lock);
+        if (lock) {
+            drain_reads();
+        }
+    }
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
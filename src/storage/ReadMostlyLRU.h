@@ -0,0 +1,83 @@
+#ifndef AFINA_STORAGE_READ_MOSTLY_LRU_H
+#define AFINA_STORAGE_READ_MOSTLY_LRU_H
+
+#include <array>
+#include <shared_mutex>
+#include <string>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU tuned for read-heavy workloads
+ * Get runs under shared lock and never touches list pointers. Instead each reader records node it has
+ * found into its own per-thread buffer, recorded promotions are applied in batch by the next writer or by
+ * the reader which fills its buffer up. Nodes which are already close to the list tail are not recorded at
+ * all as moving them doesn't change eviction order much.
+ *
+ * Buffers are lossy: if buffer is full and lock is busy then promotion gets dropped, so LRU order is
+ * approximate.
+ */
+class ReadMostlyLRU : public SimpleLRU {
+public:
+    ReadMostlyLRU(size_t max_size = 1024, std::shared_ptr<AdmissionPolicy> admission = nullptr)
+        : SimpleLRU(max_size, admission) {}
+    ~ReadMostlyLRU() {}
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override;
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Update(const std::string &key, const Updater &update) override;
+
+    // see SimpleLRU.h
+    bool Add(const std::string &key, const std::string &value, const Check &present) override;
+
+    // see SimpleLRU.h
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override;
+
+    // see SimpleLRU.h
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override;
+
+    // see SimpleLRU.h
+    void Freeze(const std::function<void()> &frozen) override;
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Promotions recorded by a single thread, written only under shared lock by the owner
+    // thread and read only under exclusive lock
+    struct read_buffer {
+        std::array<lru_node *, 64> nodes;
+        std::size_t size = 0;
+    };
+
+    // Applies all recorded promotions, must be called under exclusive lock
+    void drain_reads();
+
+    std::shared_mutex _m;
+
+    Concurrency::ThreadLocal<read_buffer> _reads;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_READ_MOSTLY_LRU_H
@@ -0,0 +1,68 @@
+#include "Segment.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// See Segment.h
+Segment::Segment(std::size_t size) : _size(size), _fd(-1), _existed(false) {
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error(std::string("Failed to map memory: ") + std::strerror(errno));
+    }
+    _data = static_cast<char *>(data);
+}
+
+// See Segment.h
+Segment::Segment(const std::string &name, std::size_t size) : _size(size), _existed(false) {
+    _fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to open shared memory " + name + ": " + std::strerror(errno));
+    }
+
+    // Lock goes away with the descriptor, so process that died doesn't keep segment locked
+    if (flock(_fd, LOCK_EX | LOCK_NB) != 0) {
+        int error = errno;
+        close(_fd);
+        throw std::runtime_error("Shared memory " + name + " is used by another process: " + std::strerror(error));
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0 || (std::size_t(st.st_size) != size && ftruncate(_fd, size) != 0)) {
+        int error = errno;
+        close(_fd);
+        throw std::runtime_error("Failed to size shared memory " + name + ": " + std::strerror(error));
+    }
+    _existed = (std::size_t(st.st_size) == size);
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+        int error = errno;
+        close(_fd);
+        throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(error));
+    }
+    _data = static_cast<char *>(data);
+}
+
+// See Segment.h
+Segment::~Segment() {
+    munmap(_data, _size);
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+// See Segment.h
+bool Segment::Unlink(const std::string &name) { return shm_unlink(name.c_str()) == 0; }
+
+} // namespace Backend
+} // namespace Afina
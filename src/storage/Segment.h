@@ -0,0 +1,71 @@
+#ifndef AFINA_STORAGE_SEGMENT_H
+#define AFINA_STORAGE_SEGMENT_H
+
+#include <cstddef>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Memory segment for storage data
+ * Single mapping of either private anonymous memory or named POSIX shared memory object. Named segment outlives the
+ * process, so the next process, e.g. the new binary after upgrade, could map the same data again. Data inside must
+ * refer to itself by offsets from the segment start since every process maps it at its own address.
+ *
+ * Named segment is locked exclusively by the process that maps it, so two processes never use it at once. Lock is
+ * released by the kernel if process dies, so segment owner must mark data consistent by itself, see SlabLRU.
+ *
+ * Memory is not touched by the segment: pages are allocated on first access and are zero filled unless they have
+ * been written before by the previous owner
+ */
+class Segment {
+public:
+    /**
+     * Maps private anonymous memory
+     *
+     * @param size of the segment in bytes
+     */
+    explicit Segment(std::size_t size);
+
+    /**
+     * Maps named shared memory object, creating it if it doesn't exist. Object of different size is resized, its
+     * content is undefined then. Throws std::runtime_error if object can't be mapped or is used by another process
+     *
+     * @param name of the object, like "/afina"
+     * @param size of the segment in bytes
+     */
+    Segment(const std::string &name, std::size_t size);
+
+    ~Segment();
+
+    Segment(const Segment &) = delete;
+    Segment &operator=(const Segment &) = delete;
+
+    inline char *data() const { return _data; }
+    inline std::size_t size() const { return _size; }
+
+    // Returns true if segment is named shared memory
+    inline bool shared() const { return _fd != -1; }
+
+    // Returns true if named segment has existed with the same size before it was mapped
+    inline bool existed() const { return _existed; }
+
+    /**
+     * Removes named shared memory object, mappings stay valid until unmapped
+     */
+    static bool Unlink(const std::string &name);
+
+private:
+    char *_data;
+    std::size_t _size;
+
+    // Descriptor holding the lock of the named segment, -1 for anonymous one
+    int _fd;
+    bool _existed;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SEGMENT_H
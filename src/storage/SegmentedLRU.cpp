@@ -0,0 +1,361 @@
+#include "SegmentedLRU.h"
+
+#include <chrono>
+#include <iterator>
+
+namespace Afina {
+namespace Backend {
+
+// Number of cold items maintainer checks from the tail on each pass
+static constexpr std::size_t maintain_batch = 128;
+
+// See SegmentedLRU.h
+SegmentedLRU::SegmentedLRU(size_t max_size, std::shared_ptr<AdmissionPolicy> admission)
+    : _max_size(max_size), _evictions(0), _admission(admission), _running(false) {
+    _limits[sHot] = max_size / 5;
+    _limits[sWarm] = max_size / 5 * 2;
+    _limits[sCold] = max_size;
+    for (auto &s : _sizes) {
+        s = 0;
+    }
+}
+
+// See SegmentedLRU.h
+SegmentedLRU::~SegmentedLRU() { Stop(); }
+
+// See SegmentedLRU.h
+void SegmentedLRU::Start() {
+    std::unique_lock<std::mutex> lock(_maintainer_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _maintainer = std::thread(&SegmentedLRU::OnRun, this);
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_maintainer_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _maintainer_cv.notify_all();
+    _maintainer.join();
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::OnRun() {
+    std::unique_lock<std::mutex> lock(_maintainer_mutex);
+    while (_running) {
+        lock.unlock();
+        Maintain();
+        lock.lock();
+
+        _maintainer_cv.wait_for(lock, std::chrono::milliseconds(10), [this] { return !_running; });
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Maintain() {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    balance();
+
+    // Rescue recently accessed items before they get evicted
+    item_list &cold = _segments[sCold];
+    auto it = cold.end();
+    for (std::size_t i = 0; i < maintain_batch && it != cold.begin(); i++) {
+        auto cur = std::prev(it);
+        if (cur->active.exchange(false, std::memory_order_relaxed)) {
+            move(cur, sWarm);
+        } else {
+            it = cur;
+        }
+    }
+    balance();
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::move(item_list::iterator it, Segment to) {
+    std::size_t size = item_size(*it);
+    _sizes[it->segment] -= size;
+    _sizes[to] += size;
+    _segments[to].splice(_segments[to].begin(), _segments[it->segment], it);
+    it->segment = to;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::balance() {
+    while (_sizes[sHot] > _limits[sHot]) {
+        auto it = std::prev(_segments[sHot].end());
+        move(it, it->active.exchange(false, std::memory_order_relaxed) ? sWarm : sCold);
+    }
+
+    // Active warm items get one more round in the warm segment
+    while (_sizes[sWarm] > _limits[sWarm]) {
+        auto it = std::prev(_segments[sWarm].end());
+        move(it, it->active.exchange(false, std::memory_order_relaxed) ? sWarm : sCold);
+    }
+}
+
+// See SegmentedLRU.h
+SegmentedLRU::item_list::iterator SegmentedLRU::find_victim() {
+    for (;;) {
+        item_list &cold = _segments[sCold];
+        if (cold.empty()) {
+            // Everything fits into hot and warm segments, force the oldest one to the cold
+            Segment from = _segments[sWarm].empty() ? sHot : sWarm;
+            auto it = std::prev(_segments[from].end());
+            it->active.store(false, std::memory_order_relaxed);
+            move(it, sCold);
+            continue;
+        }
+
+        auto it = std::prev(cold.end());
+        if (it->active.exchange(false, std::memory_order_relaxed)) {
+            move(it, sWarm);
+            continue;
+        }
+        return it;
+    }
+}
+
+// See SegmentedLRU.h
+const SegmentedLRU::item &SegmentedLRU::peek_victim() const {
+    // The first inactive cold item from the tail. Active ones are rescued to the warm segment, and once cold is
+    // empty the oldest warm item, or hot one if there is no warm, is forced down
+    const item_list &cold = _segments[sCold];
+    for (auto it = cold.rbegin(); it != cold.rend(); ++it) {
+        if (!it->active.load(std::memory_order_relaxed)) {
+            return *it;
+        }
+    }
+    if (!_segments[sWarm].empty()) {
+        return _segments[sWarm].back();
+    }
+    return cold.empty() ? _segments[sHot].back() : cold.back();
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::free_space(std::size_t size) {
+    while (_sizes[sHot] + _sizes[sWarm] + _sizes[sCold] + size > _max_size) {
+        remove(find_victim());
+        _evictions++;
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::remove(item_list::iterator it) {
+    _sizes[it->segment] -= item_size(*it);
+    const std::string *key = it->key;
+    _segments[it->segment].erase(it);
+    _index.erase(*key);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::put(const std::string &key, const std::string &value, bool check_admission) {
+    std::size_t size = key.size() + value.size();
+    // Victim is only looked at: rejected key must leave active bits and segments as they are
+    if (check_admission && _admission && _sizes[sHot] + _sizes[sWarm] + _sizes[sCold] + size > _max_size &&
+        !_admission->Admit(key, *peek_victim().key)) {
+        return false;
+    }
+
+    free_space(size);
+
+    item_list &hot = _segments[sHot];
+    hot.emplace_front(sHot);
+    auto it = _index.emplace(key, hot.begin()).first;
+    hot.front().key = &it->first;
+    hot.front().value = value;
+    _sizes[sHot] += size;
+
+    balance();
+    return true;
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Put(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_m);
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        // Existing item is replaced by the new one, so it could be never evicted in order to free space for itself
+        remove(it->second);
+        return put(key, value, false);
+    }
+    return put(key, value, true);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_m);
+    if (_index.find(key) != _index.end()) {
+        return false;
+    }
+    return put(key, value, true);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Set(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_m);
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+    remove(it->second);
+    return put(key, value, false);
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Delete(const std::string &key) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+    remove(it->second);
+    return true;
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Get(const std::string &key, std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::shared_lock<std::shared_mutex> lock(_m);
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    item &i = *it->second;
+    value = i.value;
+    if (!i.active.load(std::memory_order_relaxed)) {
+        i.active.store(true, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                            std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    std::string key;
+    if (_admission) {
+        for (auto &k : keys) {
+            key.assign(k);
+            _admission->Record(key);
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> lock(_m);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        key.assign(keys[i]);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            continue;
+        }
+
+        item &it_item = *it->second;
+        values[i] = it_item.value;
+        found[i] = true;
+        if (!it_item.active.load(std::memory_order_relaxed)) {
+            it_item.active.store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Update(const std::string &key, const Updater &update) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_m);
+    auto it = _index.find(key);
+    const std::string *current = nullptr;
+    if (it != _index.end()) {
+        current = &it->second->value;
+        it->second->active.store(true, std::memory_order_relaxed);
+    }
+
+    std::string updated;
+    switch (update(current, updated)) {
+    case UpdateAction::Store:
+        if (key.size() + updated.size() > _max_size) {
+            return false;
+        }
+        if (it != _index.end()) {
+            remove(it->second);
+            return put(key, updated, false);
+        }
+        return put(key, updated, true);
+    case UpdateAction::Remove:
+        if (it != _index.end()) {
+            remove(it->second);
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Freeze(const std::function<void()> &frozen) {
+    std::unique_lock<std::shared_mutex> lock(_m);
+    frozen();
+}
+
+// See SegmentedLRU.h
+bool SegmentedLRU::Scan(const Visitor &visit) {
+    // Cold items are the next to be evicted and warm ones were accessed more than once, segment tails are the least
+    // recent items
+    for (Segment s : {sCold, sHot, sWarm}) {
+        for (auto it = _segments[s].rbegin(); it != _segments[s].rend(); it++) {
+            visit(*it->key, it->value);
+        }
+    }
+    return true;
+}
+
+// See SegmentedLRU.h
+void SegmentedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::shared_lock<std::shared_mutex> lock(_m);
+    stats.emplace_back("curr_items", std::to_string(_index.size()));
+    stats.emplace_back("bytes", std::to_string(_sizes[sHot] + _sizes[sWarm] + _sizes[sCold]));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("hot_bytes", std::to_string(_sizes[sHot]));
+    stats.emplace_back("warm_bytes", std::to_string(_sizes[sWarm]));
+    stats.emplace_back("cold_bytes", std::to_string(_sizes[sCold]));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,161 @@
+#ifndef AFINA_STORAGE_SEGMENTED_LRU_H
+#define AFINA_STORAGE_SEGMENTED_LRU_H
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <afina/Storage.h>
+
+#include "AdmissionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Segmented LRU, memcached style
+ * Items are kept in three LRU lists:
+ * - hot: probation segment, all new items get there
+ * - warm: protected segment, items which were accessed once more after insertion
+ * - cold: eviction candidates, items are evicted from its tail
+ *
+ * Get never relinks anything, it runs under shared lock and only marks item as active. Active items are moved
+ * between segments later: by writer once segment grows over its limit or by the background maintainer thread,
+ * which is running between Start and Stop calls. Maintainer also rescues active items from the cold segment, so
+ * that they aren't evicted just because no write happens in between.
+ *
+ * Hot segment is limited by 20% of the storage size and warm one by 40%.
+ *
+ * That is thread safe implementation
+ */
+class SegmentedLRU : public Afina::Storage {
+public:
+    SegmentedLRU(size_t max_size = 1024, std::shared_ptr<AdmissionPolicy> admission = nullptr);
+    ~SegmentedLRU();
+
+    // Starts maintainer thread
+    void Start() override;
+
+    // Stops maintainer thread
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &update) override;
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override;
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &frozen) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Visitor &visit) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Runs single pass of the maintainer: balances segments and moves active cold items to warm one
+     */
+    void Maintain();
+
+private:
+    enum Segment : uint8_t { sHot = 0, sWarm, sCold, sCount };
+
+    struct item {
+        // Points to key owned by index
+        const std::string *key;
+        std::string value;
+        Segment segment;
+
+        // Item has been accessed since it was moved last time
+        std::atomic<bool> active;
+
+        item(Segment s) : key(nullptr), segment(s), active(false) {}
+    };
+
+    using item_list = std::list<item>;
+
+    inline std::size_t item_size(const item &it) const { return it.key->size() + it.value.size(); }
+
+    // Moves item to the head of the given segment
+    void move(item_list::iterator it, Segment to);
+
+    // Moves items from hot and warm tails until both fit into its limits
+    void balance();
+
+    // Evicts items from cold segment until there is space for size more bytes
+    void free_space(std::size_t size);
+
+    // Returns iterator on the next item to be evicted
+    item_list::iterator find_victim();
+
+    // Returns the item find_victim would select, neither active bits nor segments are changed
+    const item &peek_victim() const;
+
+    void remove(item_list::iterator it);
+
+    // Inserts new item into hot segment, returns false if admission policy rejects it
+    bool put(const std::string &key, const std::string &value, bool check_admission);
+
+    // Background thread function
+    void OnRun();
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    const std::size_t _max_size;
+
+    // Size limits for each segment
+    std::size_t _limits[sCount];
+
+    // Number of bytes in each segment
+    std::size_t _sizes[sCount];
+
+    // Number of items removed to free space for others
+    std::size_t _evictions;
+
+    // Segments, head is the most recent item
+    item_list _segments[sCount];
+
+    // Index of items, owns keys
+    std::unordered_map<std::string, item_list::iterator> _index;
+
+    // Optional admission filter, could be nullptr
+    std::shared_ptr<AdmissionPolicy> _admission;
+
+    // Get acquires it shared, everything else exclusively
+    std::shared_mutex _m;
+
+    // Maintainer thread and its stop signal
+    std::thread _maintainer;
+    std::mutex _maintainer_mutex;
+    std::condition_variable _maintainer_cv;
+    bool _running;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SEGMENTED_LRU_H
@@ -0,0 +1,358 @@
+#include "ShardedStorage.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+// Scratch buffers of the MultiGet, kept per thread so that batches don't allocate once buffers are grown
+struct multiget_batch {
+    std::vector<std::size_t> hash;
+    std::vector<std::size_t> shard;
+    std::vector<std::size_t> first;
+    std::vector<std::size_t> order;
+
+    // Generation to replicate value of the key with, 0 if key isn't hot
+    std::vector<uint64_t> generation;
+
+    // Sub batch of the single shard
+    std::vector<std::string_view> keys;
+    std::vector<std::string> values;
+    std::vector<bool> found;
+};
+
+// See ShardedStorage.h
+ShardedStorage::ShardedStorage(std::size_t shards, const Factory &factory, std::size_t hot_keys)
+    : _hot_keys(hot_keys), _versioned(true) {
+    if (shards == 0) {
+        throw std::invalid_argument("Sharded storage needs at least one shard");
+    }
+
+    _shards.reserve(shards);
+    for (std::size_t i = 0; i < shards; i++) {
+        _shards.emplace_back(factory(i));
+        _versioned = _shards.back()->OnEvict([this](const std::string &key) { invalidate(hash_of(key)); }) &&
+                     _versioned;
+    }
+    _generations.reset(new generation[Generations]);
+
+    // Copy of the key evicted silently would be served forever
+    if (!_versioned) {
+        _hot_keys = 0;
+    }
+}
+
+// See ShardedStorage.h
+void ShardedStorage::Start() {
+    for (auto &shard : _shards) {
+        shard->Start();
+    }
+}
+
+// See ShardedStorage.h
+void ShardedStorage::Stop() {
+    for (auto &shard : _shards) {
+        shard->Stop();
+    }
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->Put(key, value);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->PutIfAbsent(key, value);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Set(const std::string &key, const std::string &value) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->Set(key, value);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Delete(const std::string &key) {
+    std::size_t hash = hash_of(key);
+    bool deleted = _shards[shard_of(hash)]->Delete(key);
+    invalidate(hash);
+    return deleted;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Get(const std::string &key, std::string &value) {
+    std::size_t hash = hash_of(key);
+    if (_hot_keys == 0) {
+        return _shards[shard_of(hash)]->Get(key, value);
+    }
+
+    hot_cache &cache = local_cache();
+    if (replica_get(cache, hash, key, value)) {
+        return true;
+    }
+
+    uint64_t generation = count_read(cache, hash);
+    bool found = _shards[shard_of(hash)]->Get(key, value);
+    if (found && generation != 0) {
+        replicate(cache, hash, key, value, generation);
+    }
+    return found;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Update(const std::string &key, const Updater &update) {
+    std::size_t hash = hash_of(key);
+    bool changed = _shards[shard_of(hash)]->Update(key, update);
+    invalidate(hash);
+    return changed;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Add(const std::string &key, const std::string &value, const Check &present) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->Add(key, value, present);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Replace(const std::string &key, const std::string &value, const Check &present) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->Replace(key, value, present);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Insert(const std::string &key, const std::string &data, std::size_t offset,
+                            const Patch &patch) {
+    std::size_t hash = hash_of(key);
+    bool stored = _shards[shard_of(hash)]->Insert(key, data, offset, patch);
+    invalidate(hash);
+    return stored;
+}
+
+// See ShardedStorage.h
+void ShardedStorage::MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                              std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+    hot_cache *cache = _hot_keys != 0 ? &local_cache() : nullptr;
+
+    // Hash all keys up front and order them by shard with counting sort. Keys served by replicas go to the extra
+    // group past the last shard, which is never read
+    thread_local multiget_batch batch;
+    batch.hash.resize(keys.size());
+    batch.shard.resize(keys.size());
+    batch.generation.assign(keys.size(), 0);
+    batch.first.assign(_shards.size() + 2, 0);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        batch.hash[i] = hash_of(keys[i]);
+        if (cache != nullptr && replica_get(*cache, batch.hash[i], keys[i], values[i])) {
+            found[i] = true;
+            batch.shard[i] = _shards.size();
+        } else {
+            if (cache != nullptr) {
+                batch.generation[i] = count_read(*cache, batch.hash[i]);
+            }
+            batch.shard[i] = shard_of(batch.hash[i]);
+        }
+        batch.first[batch.shard[i] + 1]++;
+    }
+    for (std::size_t s = 1; s <= _shards.size(); s++) {
+        batch.first[s] += batch.first[s - 1];
+    }
+
+    batch.order.resize(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        batch.order[batch.first[batch.shard[i]]++] = i;
+    }
+
+    // Now first[s] points to the end of the shard group, that is the beginning of the next one
+    std::size_t begin = 0;
+    for (std::size_t s = 0; s < _shards.size(); s++) {
+        std::size_t end = batch.first[s];
+        if (begin == end) {
+            continue;
+        }
+
+        batch.keys.clear();
+        for (std::size_t j = begin; j < end; j++) {
+            batch.keys.push_back(keys[batch.order[j]]);
+        }
+        _shards[s]->MultiGet(batch.keys, batch.values, batch.found);
+
+        // Swap keeps value buffers circulating between batch and caller, so nothing is copied or allocated
+        for (std::size_t j = begin; j < end; j++) {
+            std::size_t i = batch.order[j];
+            found[i] = batch.found[j - begin];
+            if (found[i]) {
+                values[i].swap(batch.values[j - begin]);
+                if (batch.generation[i] != 0) {
+                    replicate(*cache, batch.hash[i], keys[i], values[i], batch.generation[i]);
+                }
+            }
+        }
+        begin = end;
+    }
+}
+
+// See ShardedStorage.h
+ShardedStorage::hot_cache &ShardedStorage::local_cache() {
+    hot_cache &cache = _caches.get();
+    if (cache.replicas.empty()) {
+        cache.replicas.resize(_hot_keys);
+        cache.reads.assign(Generations, 0);
+    }
+    return cache;
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::replica_get(hot_cache &cache, std::size_t hash, std::string_view key, std::string &value) {
+    replica &r = cache.replicas[(hash / Generations) % _hot_keys];
+    if (!r.valid || r.key != key) {
+        return false;
+    }
+
+    // Key has been written or evicted since replica was taken
+    if (r.generation != _generations[hash % Generations].value.load()) {
+        r.valid = false;
+        return false;
+    }
+
+    value = r.value;
+    cache.hits.store(cache.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (++r.hits % TouchPeriod == 0) {
+        _shards[shard_of(hash)]->Touch(r.key);
+    }
+    return true;
+}
+
+// See ShardedStorage.h
+uint64_t ShardedStorage::count_read(hot_cache &cache, std::size_t hash) {
+    if (++cache.since_decay == DecayPeriod) {
+        cache.since_decay = 0;
+        for (auto &reads : cache.reads) {
+            reads /= 2;
+        }
+    }
+
+    uint8_t &reads = cache.reads[hash % Generations];
+    if (reads < HotReads) {
+        reads++;
+        return 0;
+    }
+
+    // Generation has to be read before value is read from the shard: if write happens in between then replica is
+    // stale from the very beginning
+    return watch(hash);
+}
+
+// See ShardedStorage.h
+uint64_t ShardedStorage::watch(std::size_t hash) {
+    // From now on writes must bump generation of the key
+    std::atomic<uint64_t> &g = _generations[hash % Generations].value;
+    uint64_t current = g.load();
+    if (current == 0) {
+        g.compare_exchange_strong(current, 1);
+        current = g.load();
+    }
+    return current;
+}
+
+// See ShardedStorage.h
+void ShardedStorage::replicate(hot_cache &cache, std::size_t hash, std::string_view key, const std::string &value,
+                               uint64_t generation) {
+    if (value.size() > MaxReplicaSize) {
+        return;
+    }
+
+    replica &r = cache.replicas[(hash / Generations) % _hot_keys];
+    r.key.assign(key);
+    r.value = value;
+    r.generation = generation;
+    r.valid = true;
+    cache.fills.store(cache.fills.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// See ShardedStorage.h
+void ShardedStorage::Freeze(const std::function<void()> &frozen) { freeze(0, frozen); }
+
+// See ShardedStorage.h
+void ShardedStorage::freeze(std::size_t shard, const std::function<void()> &frozen) {
+    // Shards are locked in order and nobody else holds two shard locks at once, so there is no deadlock
+    if (shard == _shards.size()) {
+        frozen();
+    } else {
+        _shards[shard]->Freeze([&]() { freeze(shard + 1, frozen); });
+    }
+}
+
+// See ShardedStorage.h
+bool ShardedStorage::Scan(const Visitor &visit) {
+    // Recency isn't tracked across shards, so each shard is passed in its own order
+    for (auto &shard : _shards) {
+        if (!shard->Scan(visit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See ShardedStorage.h
+uint64_t ShardedStorage::Version(std::string_view key) { return _versioned ? watch(hash_of(key)) : 0; }
+
+// See ShardedStorage.h
+void ShardedStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    // Standard statistics are summed up over shards, everything is reported per shard as well
+    static const char *summed[] = {"curr_items", "bytes", "evictions", "limit_maxbytes"};
+    uint64_t totals[sizeof(summed) / sizeof(summed[0])] = {0};
+    std::vector<std::pair<std::string, std::string>> per_shard;
+
+    std::vector<std::pair<std::string, std::string>> shard_stats;
+    for (std::size_t s = 0; s < _shards.size(); s++) {
+        shard_stats.clear();
+        _shards[s]->Stats(shard_stats);
+
+        std::string prefix = "shard_" + std::to_string(s) + ":";
+        for (auto &stat : shard_stats) {
+            for (std::size_t i = 0; i < sizeof(summed) / sizeof(summed[0]); i++) {
+                if (stat.first == summed[i]) {
+                    totals[i] += std::strtoull(stat.second.c_str(), nullptr, 10);
+                }
+            }
+            per_shard.emplace_back(prefix + stat.first, std::move(stat.second));
+        }
+    }
+
+    for (std::size_t i = 0; i < sizeof(summed) / sizeof(summed[0]); i++) {
+        stats.emplace_back(summed[i], std::to_string(totals[i]));
+    }
+    stats.emplace_back("shards", std::to_string(_shards.size()));
+
+    if (_hot_keys != 0) {
+        uint64_t hits = 0, fills = 0;
+        _caches.for_each([&](hot_cache &cache) {
+            hits += cache.hits.load(std::memory_order_relaxed);
+            fills += cache.fills.load(std::memory_order_relaxed);
+        });
+        stats.emplace_back("hot_replica_hits", std::to_string(hits));
+        stats.emplace_back("hot_replica_fills", std::to_string(fills));
+    }
+    std::move(per_shard.begin(), per_shard.end(), std::back_inserter(stats));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,197 @@
+#ifndef AFINA_STORAGE_SHARDED_STORAGE_H
+#define AFINA_STORAGE_SHARDED_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage partitioned by key hash
+ * Keys are spread over independent thread safe shards, so requests for different keys rarely wait on the same
+ * lock. Every single key operation goes to the shard key belongs to.
+ *
+ * MultiGet hashes all keys first, groups them by shard and then runs one shard MultiGet per group, so each shard
+ * lock is taken once per batch. Results are returned in the request order.
+ *
+ * Shards are created by the given factory, thread safety of the whole storage is the same as of the shards
+ *
+ * ## Hot keys replication
+ * Key which gets most of the reads makes its shard a bottleneck no matter how many shards there are. If hot_keys
+ * isn't zero then each thread counts reads per key hash and once some key gets read often enough by the thread, it
+ * keeps read-only replica of the key value in its own small cache and serves further reads from there without
+ * touching shard lock, so reads of a viral key scale with threads.
+ *
+ * Keys are mapped by hash onto generation counters. Each write to a key which could be replicated bumps generation
+ * after the shard is updated, and replica is valid only while generation is the same as it was before the value
+ * had been read from the shard, so once write returns no thread could see older value. Shards report evictions,
+ * which bump generation the same way, so evicted key isn't served by replicas either. Generations are reported as
+ * key versions for caches outside of the storage too. Shard that doesn't report evictions turns both off.
+ *
+ * Shard doesn't see reads served by replicas, so one out of TouchPeriod replica hits touches the key in the shard:
+ * it stays recently used there and admission policy keeps counting its reads
+ */
+class ShardedStorage : public Afina::Storage {
+public:
+    using Factory = std::function<std::unique_ptr<Storage>(std::size_t shard)>;
+
+    /**
+     * @param shards number of shards
+     * @param factory creates storage for each shard
+     * @param hot_keys number of hot keys replicas each thread could keep, 0 turns replication off
+     */
+    ShardedStorage(std::size_t shards, const Factory &factory, std::size_t hot_keys = 0);
+    ~ShardedStorage() {}
+
+    // Starts all shards
+    void Start() override;
+
+    // Stops all shards
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &update) override;
+
+    // Implements Afina::Storage interface
+    bool Add(const std::string &key, const std::string &value, const Check &present) override;
+
+    // Implements Afina::Storage interface
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override;
+
+    // Implements Afina::Storage interface
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override;
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override;
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &frozen) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Visitor &visit) override;
+
+    // Implements Afina::Storage interface
+    std::size_t Partitions() override { return _shards.size(); }
+
+    // Implements Afina::Storage interface
+    std::size_t Partition(std::string_view key) override { return shard_of(key); }
+
+    // Implements Afina::Storage interface
+    uint64_t Version(std::string_view key) override;
+
+    // Implements Afina::Storage interface
+    void Touch(const std::string &key) override { _shards[shard_of(key)]->Touch(key); }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Number of generation counters keys are mapped onto
+    static constexpr std::size_t Generations = 1024;
+
+    // Thread replicates key once it has read the key that many times, read counts are halved every DecayPeriod reads
+    static constexpr uint8_t HotReads = 8;
+    static constexpr uint32_t DecayPeriod = 1 << 13;
+
+    // Bigger values aren't replicated
+    static constexpr std::size_t MaxReplicaSize = 4096;
+
+    // Replica hits passed to the shard as a touch
+    static constexpr uint32_t TouchPeriod = 64;
+
+    // Generation 0 means that key was never replicated or cached, so writes don't need to bump it
+    struct alignas(64) generation {
+        std::atomic<uint64_t> value{0};
+    };
+
+    struct replica {
+        std::string key;
+        std::string value;
+        uint64_t generation = 0;
+        uint32_t hits = 0;
+        bool valid = false;
+    };
+
+    // Replicas and read counts of a single thread, only counters are read by other threads
+    struct hot_cache {
+        std::vector<replica> replicas;
+        std::vector<uint8_t> reads;
+        uint32_t since_decay = 0;
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> fills{0};
+    };
+
+    static inline std::size_t hash_of(std::string_view key) { return std::hash<std::string_view>()(key); }
+
+    inline std::size_t shard_of(std::size_t hash) const { return hash % _shards.size(); }
+
+    inline std::size_t shard_of(std::string_view key) const { return shard_of(hash_of(key)); }
+
+    // Invalidates replicas and cached copies of the key once write to it is done
+    inline void invalidate(std::size_t hash) {
+        std::atomic<uint64_t> &g = _generations[hash % Generations].value;
+        if (g.load() != 0) {
+            g.fetch_add(1);
+        }
+    }
+
+    // Returns generation of the key, starts to track it if nobody did before
+    uint64_t watch(std::size_t hash);
+
+    // Freezes shards starting from the given one, then runs function
+    void freeze(std::size_t shard, const std::function<void()> &frozen);
+
+    // Returns cache of the calling thread, sized on the first access
+    hot_cache &local_cache();
+
+    // Copies value from the replica if thread has a valid one
+    bool replica_get(hot_cache &cache, std::size_t hash, std::string_view key, std::string &value);
+
+    // Counts read of the key, returns generation to replicate value read from the shard with or 0 if key isn't hot
+    uint64_t count_read(hot_cache &cache, std::size_t hash);
+
+    // Keeps replica of the value just read from the shard
+    void replicate(hot_cache &cache, std::size_t hash, std::string_view key, const std::string &value,
+                   uint64_t generation);
+
+    std::vector<std::unique_ptr<Storage>> _shards;
+
+    std::size_t _hot_keys;
+
+    // Generations are bumped on evictions too, so values read from shards could be cached
+    bool _versioned;
+    std::unique_ptr<generation[]> _generations;
+    Concurrency::ThreadLocal<hot_cache> _caches;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_STORAGE_H
@@ -0,0 +1,385 @@
+#include "SimpleClock.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See SimpleClock.h
+void SimpleClock::remove(std::size_t idx) {
+    slot &s = _slots[idx];
+    _cur_size -= slot_size(s);
+    if (s.hot) {
+        _hot_size -= slot_size(s);
+        _hot_count--;
+    }
+
+    const std::string *key = s.key;
+    s.key = nullptr;
+    s.value.clear();
+    s.referenced = false;
+    s.hot = false;
+
+    _index.erase(*key);
+    _free_slots.push_back(idx);
+}
+
+// See SimpleClock.h
+bool SimpleClock::demote(std::size_t except) {
+    // Hand never stops on the spared slot, so there must be some other hot item
+    bool except_hot = except < _slots.size() && _slots[except].key != nullptr && _slots[except].hot;
+    if (_hot_count == (except_hot ? 1 : 0)) {
+        return false;
+    }
+
+    for (;;) {
+        std::size_t idx = _hot_hand;
+        slot &s = _slots[idx];
+        _hot_hand = (_hot_hand + 1) % _slots.size();
+        if (s.key == nullptr || !s.hot || idx == except) {
+            continue;
+        }
+
+        if (s.referenced.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+
+        s.hot = false;
+        _hot_size -= slot_size(s);
+        _hot_count--;
+        return true;
+    }
+}
+
+// See SimpleClock.h
+std::size_t SimpleClock::find_victim(std::size_t except) {
+    for (;;) {
+        // No cold item could be evicted, so make one
+        std::size_t cold_count = _index.size() - _hot_count;
+        if (except < _slots.size() && _slots[except].key != nullptr && !_slots[except].hot) {
+            cold_count--;
+        }
+        if (cold_count == 0) {
+            demote(except);
+            continue;
+        }
+
+        std::size_t idx = _cold_hand;
+        slot &s = _slots[idx];
+        if (s.key != nullptr && !s.hot && idx != except) {
+            if (!s.referenced.exchange(false, std::memory_order_relaxed)) {
+                // Hand stays on the victim: if it survives admission it will be checked first next time
+                return idx;
+            }
+
+            // Item has been used since last hand visit, it is either a hot one or
+            // gets one more round
+            if (_scan_resistant) {
+                s.hot = true;
+                _hot_size += slot_size(s);
+                _hot_count++;
+                while (_hot_size > _hot_max_size && demote(except)) {
+                }
+            }
+        }
+        _cold_hand = (_cold_hand + 1) % _slots.size();
+    }
+}
+
+// See SimpleClock.h
+std::size_t SimpleClock::peek_victim() const {
+    // Cold hand evicts the first unreferenced cold item, or the first cold one once it has cleared all bits. If all
+    // items are hot then hot hand demotes one of them first
+    for (bool hot : {false, true}) {
+        std::size_t hand = hot ? _hot_hand : _cold_hand, fallback = _slots.size();
+        for (std::size_t i = 0; i < _slots.size(); i++) {
+            std::size_t idx = (hand + i) % _slots.size();
+            const slot &s = _slots[idx];
+            if (s.key == nullptr || s.hot != hot) {
+                continue;
+            }
+            if (!s.referenced.load(std::memory_order_relaxed)) {
+                return idx;
+            }
+            if (fallback == _slots.size()) {
+                fallback = idx;
+            }
+        }
+        if (fallback != _slots.size()) {
+            return fallback;
+        }
+    }
+    return _slots.size();
+}
+
+// See SimpleClock.h
+void SimpleClock::free_space(std::size_t size, std::size_t except) {
+    while (_cur_size + size > _max_size) {
+        std::size_t victim = find_victim(except);
+        if (_evicted) {
+            _evicted(*_slots[victim].key);
+        }
+        remove(victim);
+        _evictions++;
+        _cold_hand = (victim + 1) % _slots.size();
+    }
+}
+
+// See SimpleClock.h
+void SimpleClock::set_value(std::size_t idx, const std::string &value) {
+    slot &s = _slots[idx];
+    if (value.size() > s.value.size()) {
+        free_space(value.size() - s.value.size(), idx);
+    }
+
+    _cur_size += value.size();
+    _cur_size -= s.value.size();
+    if (s.hot) {
+        _hot_size += value.size();
+        _hot_size -= s.value.size();
+    }
+    s.value = value;
+    s.referenced.store(true, std::memory_order_relaxed);
+}
+
+// See SimpleClock.h
+bool SimpleClock::insert(const std::string &key, const std::string &value) {
+    // Victim is only looked at: rejected key must leave reference bits and hot items as they are
+    if (_admission && _cur_size + key.size() + value.size() > _max_size) {
+        std::size_t victim = peek_victim();
+        if (victim < _slots.size() && !_admission->Admit(key, *_slots[victim].key)) {
+            return false;
+        }
+    }
+
+    free_space(key.size() + value.size(), _slots.size());
+
+    std::size_t idx;
+    if (_free_slots.empty()) {
+        idx = _slots.size();
+        _slots.emplace_back();
+    } else {
+        idx = _free_slots.back();
+        _free_slots.pop_back();
+    }
+
+    auto it = _index.emplace(key, idx).first;
+    slot &s = _slots[idx];
+    s.key = &it->first;
+    s.value = value;
+    _cur_size += key.size() + value.size();
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Put(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        set_value(it->second, value);
+        return true;
+    }
+    return insert(key, value);
+}
+
+// See SimpleClock.h
+bool SimpleClock::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (_index.find(key) != _index.end()) {
+        return false;
+    }
+    return SimpleClock::Put(key, value);
+}
+
+// See SimpleClock.h
+bool SimpleClock::Set(const std::string &key, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    set_value(it->second, value);
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Delete(const std::string &key) {
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    remove(it->second);
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Get(const std::string &key, std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    slot &s = _slots[it->second];
+    value = s.value;
+    s.referenced.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Update(const std::string &key, const Updater &update) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    // Updater reads value right from the slot, so key is looked up only once
+    auto it = _index.find(key);
+    slot *s = (it == _index.end()) ? nullptr : &_slots[it->second];
+
+    std::string updated;
+    switch (update(s != nullptr ? &s->value : nullptr, updated)) {
+    case UpdateAction::Store:
+        if (key.size() + updated.size() > _max_size) {
+            return false;
+        } else if (s == nullptr) {
+            return insert(key, updated);
+        }
+        set_value(it->second, updated);
+        return true;
+    case UpdateAction::Remove:
+        if (s == nullptr) {
+            return false;
+        }
+        remove(it->second);
+        return true;
+    default:
+        if (s != nullptr) {
+            s->referenced.store(true, std::memory_order_relaxed);
+        }
+        return false;
+    }
+}
+
+// See SimpleClock.h
+bool SimpleClock::Add(const std::string &key, const std::string &value, const Check &present) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return insert(key, value);
+    } else if (present(_slots[it->second].value)) {
+        _slots[it->second].referenced.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    set_value(it->second, value);
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Replace(const std::string &key, const std::string &value, const Check &present) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it == _index.end() || !present(_slots[it->second].value)) {
+        return false;
+    }
+    set_value(it->second, value);
+    return true;
+}
+
+// See SimpleClock.h
+bool SimpleClock::Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    // Data is inserted right into the slot, value is never copied
+    std::size_t idx = it->second;
+    if (key.size() + _slots[idx].value.size() + data.size() > _max_size || !patch(_slots[idx].value)) {
+        return false;
+    }
+    free_space(data.size(), idx);
+
+    slot &s = _slots[idx];
+    s.value.insert(std::min(offset, s.value.size()), data);
+    _cur_size += data.size();
+    if (s.hot) {
+        _hot_size += data.size();
+    }
+    s.referenced.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+// See SimpleClock.h
+void SimpleClock::MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                           std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    // Calls are qualified, so that thread safe subclass could run the whole batch under its lock
+    std::string key;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        key.assign(keys[i]);
+        found[i] = SimpleClock::Get(key, values[i]);
+    }
+}
+
+// See SimpleClock.h
+bool SimpleClock::Scan(const Visitor &visit) {
+    // Clock doesn't keep recency order, but items are evicted in the cold hand order, so it starts from the next
+    // victim. Items referenced since the hand has passed them go last
+    for (int referenced = 0; referenced < 2; referenced++) {
+        for (std::size_t i = 0; i < _slots.size(); i++) {
+            slot &s = _slots[(_cold_hand + i) % _slots.size()];
+            if (s.key != nullptr && s.referenced.load(std::memory_order_relaxed) == bool(referenced)) {
+                visit(*s.key, s.value);
+            }
+        }
+    }
+    return true;
+}
+
+// See SimpleClock.h
+void SimpleClock::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_index.size()));
+    stats.emplace_back("bytes", std::to_string(_cur_size));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("hot_items", std::to_string(_hot_count));
+}
+
+} // namespace Backend
+} // namespace Afina
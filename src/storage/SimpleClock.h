@@ -0,0 +1,157 @@
+#ifndef AFINA_STORAGE_SIMPLE_CLOCK_H
+#define AFINA_STORAGE_SIMPLE_CLOCK_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "AdmissionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK cache
+ * Items live in a flat array of slots, each slot has reference bit which Get sets on hit. No list manipulations
+ * happens on hit, so Get never writes anything but that bit. Eviction is done by a "hand" sweeping over slots:
+ * referenced slots lose their bit and get a second chance, unreferenced ones are evicted.
+ *
+ * In scan resistant mode implements simplified CLOCK-Pro: items are divided onto cold and hot ones. New items are
+ * cold, cold items referenced while the cold hand reaches them get promoted to hot. Cold hand evicts only cold items,
+ * hot hand demotes unreferenced hot items only when hot part grows over its limit. So stream of one-time accessed
+ * keys is evicted without touching hot set.
+ *
+ * If admission policy is given then new key that requires eviction is stored only if policy prefers it over the
+ * item cold hand points to.
+ *
+ * That is NOT thread safe implementation, except that Get could run concurrently with other Get calls
+ */
+class SimpleClock : public Afina::Storage {
+public:
+    SimpleClock(size_t max_size = 1024, bool scan_resistant = false,
+                std::shared_ptr<AdmissionPolicy> admission = nullptr)
+        : _max_size(max_size), _hot_max_size(max_size / 4 * 3), _scan_resistant(scan_resistant), _cur_size(0),
+          _hot_size(0), _hot_count(0), _evictions(0), _cold_hand(0), _hot_hand(0), _admission(admission) {}
+    ~SimpleClock() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &update) override;
+
+    // Implements Afina::Storage interface
+    bool Add(const std::string &key, const std::string &value, const Check &present) override;
+
+    // Implements Afina::Storage interface
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override;
+
+    // Implements Afina::Storage interface
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override;
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Visitor &visit) override;
+
+    // Implements Afina::Storage interface
+    bool OnEvict(const Evicted &evicted) override {
+        _evicted = evicted;
+        return true;
+    }
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    struct slot {
+        // Points to the key owned by index, nullptr if slot is free
+        const std::string *key;
+        std::string value;
+        std::atomic<bool> referenced;
+        bool hot;
+
+        slot() : key(nullptr), referenced(false), hot(false) {}
+        slot(slot &&other)
+            : key(other.key), value(std::move(other.value)), referenced(other.referenced.load()), hot(other.hot) {}
+    };
+
+    // Evicts cold items until there are space for size more bytes. Slot except is never evicted
+    void free_space(std::size_t size, std::size_t except);
+
+    // Moves cold hand until it points to the item to be evicted. Slot except is never selected
+    std::size_t find_victim(std::size_t except);
+
+    // Returns the item find_victim would most likely select, neither hands nor reference bits are changed
+    std::size_t peek_victim() const;
+
+    // Moves hot hand until one item demoted to cold, returns false if there is no hot item but except
+    bool demote(std::size_t except);
+
+    void remove(std::size_t idx);
+
+    void set_value(std::size_t idx, const std::string &value);
+
+    // Stores value for the key that isn't in the index yet, returns false if admission policy rejects it
+    bool insert(const std::string &key, const std::string &value);
+
+    inline std::size_t slot_size(const slot &s) const { return s.key->size() + s.value.size(); }
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    const std::size_t _max_size;
+
+    // Maximum number of bytes hot items could take
+    const std::size_t _hot_max_size;
+
+    const bool _scan_resistant;
+
+    std::size_t _cur_size;
+    std::size_t _hot_size;
+    std::size_t _hot_count;
+
+    // Number of items removed to free space for others
+    std::size_t _evictions;
+
+    // Position of hands in the slots array
+    std::size_t _cold_hand;
+    std::size_t _hot_hand;
+
+    // All items, including free slots
+    std::vector<slot> _slots;
+
+    // Indexes of free slots in _slots
+    std::vector<std::size_t> _free_slots;
+
+    // Index of slots, owns keys
+    std::unordered_map<std::string, std::size_t> _index;
+
+    // Optional admission filter, could be nullptr
+    std::shared_ptr<AdmissionPolicy> _admission;
+
+    // Optional eviction listener, could be empty
+    Evicted _evicted;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SIMPLE_CLOCK_H
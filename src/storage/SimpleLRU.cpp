@@ -1,5 +1,7 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+
 namespace Afina {
 namespace Backend {
 
@@ -10,11 +12,13 @@ void SimpleLRU::move_to_tail(lru_node &node) {
     tmp->next = std::move(_lru_tail->prev->next);
     _lru_tail->prev = tmp.get();
     tmp->prev->next = std::move(tmp);
+    node.stamp = ++_clock;
 }
 
 void SimpleLRU::append_node(const std::string &key, const std::string &value) {
     std::unique_ptr<lru_node> node(new lru_node(key));
     node->value = value;
+    node->stamp = ++_clock;
     _cur_size += key.size() + value.size();
 
     node->prev = _lru_tail->prev;
@@ -36,27 +40,52 @@ void SimpleLRU::remove_node(lru_node *node, bool erase = true) {
     left->next->prev = left;
 }
 
+// See SimpleLRU.h
+bool SimpleLRU::insert(const std::string &key, const std::string &value) {
+    size_t size = key.size() + value.size();
+    if (_admission && _cur_size + size > _max_size && !_admission->Admit(key, _lru_head->next->key)) {
+        return false;
+    }
+    while (_cur_size + size > _max_size) {
+        evict();
+    }
+    append_node(key, value);
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::assign(lru_node &node, const std::string &value) {
+    move_to_tail(node);
+    while (_cur_size - node.value.size() + value.size() > _max_size) {
+        evict();
+    }
+    _cur_size += value.size() - node.value.size();
+    node.value = value;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::evict() {
+    if (_evicted) {
+        _evicted(_lru_head->next->key);
+    }
+    remove_node(_lru_head->next.get());
+    _evictions++;
+}
+
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Put(const std::string &key, const std::string &value) {
     size_t size = key.size() + value.size();
     if (size > _max_size) {
         return false;
     }
+    if (_admission) {
+        _admission->Record(key);
+    }
     auto it = _lru_index.find(key);
     if (it == _lru_index.end()) {
-        while (_cur_size + size > _max_size) {
-            remove_node(_lru_head->next.get());
-        }
-        append_node(key, value);
-    } else {
-        lru_node &tmp = it->second.get();
-        move_to_tail(tmp);
-        while (_cur_size - tmp.value.size() + value.size() > _max_size) {
-            remove_node(_lru_head->next.get());
-        }
-        _cur_size += value.size() - tmp.value.size();
-        tmp.value = value;
+        return insert(key, value);
     }
+    assign(it->second.get(), value);
     return true;
 }
 
@@ -64,7 +93,7 @@ bool SimpleLRU::Put(const std::string &key, const std::string &value) {
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
     auto it = _lru_index.find(key);
     if (it == _lru_index.end()) {
-        return Put(key, value);
+        return SimpleLRU::Put(key, value);
     } else {
         return false;
     }
@@ -75,17 +104,14 @@ bool SimpleLRU::Set(const std::string &key, const std::string &value) {
     if (key.size() + value.size() > _max_size) {
         return false;
     }
+    if (_admission) {
+        _admission->Record(key);
+    }
     auto it = _lru_index.find(key);
     if (it == _lru_index.end()) {
         return false;
     }
-    lru_node &tmp = it->second.get();
-    move_to_tail(tmp);
-    while (_cur_size + value.size() - tmp.value.size() > _max_size) {
-        remove_node(_lru_head->next.get());
-    }
-    _cur_size += value.size() - tmp.value.size();
-    tmp.value = value;
+    assign(it->second.get(), value);
     return true;
 }
 
@@ -101,6 +127,9 @@ bool SimpleLRU::Delete(const std::string &key) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
     auto it = _lru_index.find(key);
     if (it == _lru_index.end()) {
         return false;
@@ -110,5 +139,132 @@ bool SimpleLRU::Get(const std::string &key, std::string &value) {
     move_to_tail(tmp);
     return true;
 }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Update(const std::string &key, const Updater &update) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    // Updater reads value right from the node, so key is looked up only once
+    auto it = _lru_index.find(key);
+    lru_node *node = (it == _lru_index.end()) ? nullptr : &it->second.get();
+
+    std::string updated;
+    switch (update(node != nullptr ? &node->value : nullptr, updated)) {
+    case UpdateAction::Store:
+        if (key.size() + updated.size() > _max_size) {
+            return false;
+        } else if (node == nullptr) {
+            return insert(key, updated);
+        }
+        assign(*node, updated);
+        return true;
+    case UpdateAction::Remove:
+        if (node == nullptr) {
+            return false;
+        }
+        remove_node(node);
+        return true;
+    default:
+        if (node != nullptr) {
+            move_to_tail(*node);
+        }
+        return false;
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Add(const std::string &key, const std::string &value, const Check &present) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end()) {
+        return insert(key, value);
+    }
+
+    lru_node &node = it->second.get();
+    if (present(node.value)) {
+        move_to_tail(node);
+        return false;
+    }
+    assign(node, value);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Replace(const std::string &key, const std::string &value, const Check &present) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (_admission) {
+        _admission->Record(key);
+    }
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end() || !present(it->second.get().value)) {
+        return false;
+    }
+    assign(it->second.get(), value);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end()) {
+        return false;
+    }
+
+    // Data is inserted right into the node, value is never copied
+    lru_node &node = it->second.get();
+    if (key.size() + node.value.size() + data.size() > _max_size || !patch(node.value)) {
+        return false;
+    }
+    move_to_tail(node);
+    while (_cur_size + data.size() > _max_size) {
+        evict();
+    }
+    node.value.insert(std::min(offset, node.value.size()), data);
+    _cur_size += data.size();
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                         std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    // Calls are qualified, so that thread safe subclasses could run the whole batch under their lock
+    std::string key;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        key.assign(keys[i]);
+        found[i] = SimpleLRU::Get(key, values[i]);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Scan(const Visitor &visit) {
+    // List head is the least recently used node
+    for (lru_node *node = _lru_head->next.get(); node != _lru_tail; node = node->next.get()) {
+        visit(node->key, node->value);
+    }
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_lru_index.size()));
+    stats.emplace_back("bytes", std::to_string(_cur_size));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+}
 } // namespace Backend
 } // namespace Afina
\ No newline at end of file
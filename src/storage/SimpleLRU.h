@@ -8,16 +8,23 @@
 
 #include <afina/Storage.h>
 
+#include "AdmissionPolicy.h"
+
 namespace Afina {
     namespace Backend {
 
 /**
  * # Map based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * If admission policy is given then new key that requires eviction is stored only if
+ * policy prefers it over the least recently used one.
  */
         class SimpleLRU : public Afina::Storage {
         public:
-            SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _lru_head(new lru_node) {
+            SimpleLRU(size_t max_size = 1024, std::shared_ptr<AdmissionPolicy> admission = nullptr)
+                : _max_size(max_size), _cur_size(0), _clock(0), _evictions(0), _lru_head(new lru_node),
+              _admission(admission) {
                 std::unique_ptr<lru_node> tail(new lru_node);
                 _lru_tail = tail.get();
                 _lru_tail->prev = _lru_head.get();
@@ -47,7 +54,36 @@ namespace Afina {
             // Implements Afina::Storage interface
             bool Get(const std::string &key, std::string &value) override;
 
-        private:
+            // Implements Afina::Storage interface
+            bool Update(const std::string &key, const Updater &update) override;
+
+            // Implements Afina::Storage interface
+            bool Add(const std::string &key, const std::string &value, const Check &present) override;
+
+            // Implements Afina::Storage interface
+            bool Replace(const std::string &key, const std::string &value, const Check &present) override;
+
+            // Implements Afina::Storage interface
+            bool Insert(const std::string &key, const std::string &data, std::size_t offset,
+                        const Patch &patch) override;
+
+            // Implements Afina::Storage interface
+            void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                          std::vector<bool> &found) override;
+
+            // Implements Afina::Storage interface
+            bool Scan(const Visitor &visit) override;
+
+            // Implements Afina::Storage interface
+            bool OnEvict(const Evicted &evicted) override {
+                _evicted = evicted;
+                return true;
+            }
+
+            // Implements Afina::Storage interface
+            void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+        protected:
             // LRU cache node
             using lru_node = struct lru_node {
                 const std::string key;
@@ -55,7 +91,10 @@ namespace Afina {
                 lru_node *prev;
                 std::unique_ptr<lru_node> next;
 
-                lru_node(const std::string &key = "") : key(key), prev(nullptr), next(nullptr) {}
+                // Value of _clock when node was moved to the tail last time
+                std::size_t stamp;
+
+                lru_node(const std::string &key = "") : key(key), prev(nullptr), next(nullptr), stamp(0) {}
             };
 
             // Maximum number of bytes could be stored in this cache.
@@ -63,6 +102,13 @@ namespace Afina {
             std::size_t _max_size;
             std::size_t _cur_size;
 
+            // Counts all moves to the tail. Node that has (_clock - stamp) < N has at most N nodes
+            // closer to the tail than itself
+            std::size_t _clock;
+
+            // Number of nodes removed to free space for others
+            std::size_t _evictions;
+
             // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
             // element that wasn't used for longest time.
             //
@@ -73,11 +119,27 @@ namespace Afina {
             // Index of nodes from list above, allows fast random access to elements by lru_node#key
             std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
 
+            // Optional admission filter, could be nullptr
+            std::shared_ptr<AdmissionPolicy> _admission;
+
+            // Optional eviction listener, could be empty
+            Evicted _evicted;
+
+            void move_to_tail(lru_node &node);
+
+        private:
             void remove_node(lru_node *node, bool erase);
 
+            // Removes the least recently used node
+            void evict();
+
             void append_node(const std::string &key, const std::string &value);
 
-            void move_to_tail(lru_node &node);
+            // Stores value for the key that isn't in the index yet, returns false if admission policy rejects it
+            bool insert(const std::string &key, const std::string &value);
+
+            // Replaces value of the existing node, evicting other nodes if needed
+            void assign(lru_node &node, const std::string &value);
         };
     }// namespace Backend
 } // namespace Afina
@@ -0,0 +1,619 @@
+#include "SlabLRU.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+// Number of chunks rebalancer evicts from the moving page at once
+static constexpr std::size_t move_batch = 64;
+
+// Segment layout version, must be changed along with the structures stored in it
+static const char segment_magic[8] = {'A', 'F', 'N', 'S', 'L', 'A', 'B', '1'};
+
+// Rounds value up to the multiple of alignment
+static std::size_t align_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// FNV-1a, unlike std::hash it is the same in every build, so index in shared segment stays valid across binaries
+static uint64_t hash_key(std::string_view key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// See SlabLRU.h
+SlabLRU::SlabLRU(size_t max_size, size_t page_size, std::shared_ptr<AdmissionPolicy> admission,
+                 const std::string &segment)
+    : _page_size(std::min(page_size, max_size) & ~std::size_t(7)), _attached(false), _admission(admission),
+      _running(false) {
+    // Chunk sizes are multiple of 8, so that headers are aligned
+    std::vector<std::size_t> chunk_sizes;
+    std::size_t size = 64;
+    while (size < _page_size) {
+        chunk_sizes.push_back(size);
+        size = std::max(size + 8, (size * 5 / 4 + 7) & ~std::size_t(7));
+    }
+    chunk_sizes.push_back(_page_size);
+
+    // Index has a bucket per 256 bytes of memory, so chains are short even if all items are in the smallest class
+    _class_count = chunk_sizes.size();
+    _page_count = max_size / _page_size;
+    _bucket_count = 16;
+    while (_bucket_count < _page_count * _page_size / 256) {
+        _bucket_count *= 2;
+    }
+
+    std::size_t classes_offset = align_up(sizeof(header), 64);
+    std::size_t pages_offset = align_up(classes_offset + _class_count * sizeof(slab_class), 64);
+    std::size_t buckets_offset = align_up(pages_offset + _page_count * sizeof(page), 64);
+    std::size_t memory_offset = align_up(buckets_offset + _bucket_count * sizeof(uint64_t), 4096);
+    std::size_t total = memory_offset + _page_count * _page_size;
+
+    _segment.reset(segment.empty() ? new Segment(total) : new Segment(segment, total));
+    _base = _segment->data();
+    _header = reinterpret_cast<header *>(_base);
+    _classes = reinterpret_cast<slab_class *>(_base + classes_offset);
+    _pages = reinterpret_cast<page *>(_base + pages_offset);
+    _buckets = reinterpret_cast<uint64_t *>(_base + buckets_offset);
+    _memory = _base + memory_offset;
+
+    // Data left by the previous process is used only if it has been detached properly and has the same layout
+    _attached = _segment->existed() && std::memcmp(_header->magic, segment_magic, sizeof(segment_magic)) == 0 &&
+                _header->size == total && _header->page_size == _page_size && _header->pages == _page_count &&
+                _header->buckets == _bucket_count && _header->clean == 1;
+    if (!_attached) {
+        initialize(chunk_sizes);
+    }
+    _header->clean = 0;
+}
+
+// See SlabLRU.h
+void SlabLRU::initialize(const std::vector<std::size_t> &chunk_sizes) {
+    std::memset(_header, 0, sizeof(header));
+    _header->size = _segment->size();
+    _header->page_size = _page_size;
+    _header->pages = _page_count;
+    _header->buckets = _bucket_count;
+    _header->free_pages = _page_count;
+    _header->reassign_last_src = -1;
+    _header->reassign_last_dst = -1;
+
+    for (std::size_t i = 0; i < _class_count; i++) {
+        _classes[i] = slab_class{chunk_sizes[i], 0, 0, 0, 0, 0, 0, 0, 0};
+    }
+    for (std::size_t i = 0; i < _page_count; i++) {
+        _pages[i].slab_class = -1;
+        _pages[i].draining = 0;
+    }
+    std::memset(_buckets, 0, _bucket_count * sizeof(uint64_t));
+    std::memcpy(_header->magic, segment_magic, sizeof(segment_magic));
+}
+
+// See SlabLRU.h
+SlabLRU::~SlabLRU() {
+    Stop();
+
+    // Nothing changes data anymore, so the next process could attach to it
+    std::unique_lock<std::mutex> lock(_m);
+    _header->clean = 1;
+}
+
+// See SlabLRU.h
+void SlabLRU::Start() {
+    std::unique_lock<std::mutex> lock(_rebalancer_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _rebalancer = std::thread(&SlabLRU::OnRun, this);
+}
+
+// See SlabLRU.h
+void SlabLRU::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_rebalancer_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _rebalancer_cv.notify_all();
+    _rebalancer.join();
+}
+
+// See SlabLRU.h
+void SlabLRU::OnRun() {
+    std::unique_lock<std::mutex> lock(_rebalancer_mutex);
+    while (_running) {
+        _rebalancer_cv.wait_for(lock, std::chrono::seconds(1), [this] { return !_running; });
+        if (!_running) {
+            break;
+        }
+
+        lock.unlock();
+        Rebalance();
+        lock.lock();
+    }
+}
+
+// See SlabLRU.h
+int SlabLRU::find_class(std::size_t key_size, std::size_t value_size) const {
+    std::size_t size = sizeof(item) + key_size + value_size;
+    for (std::size_t i = 0; i < _class_count; i++) {
+        if (_classes[i].chunk_size >= size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// See SlabLRU.h
+uint64_t &SlabLRU::bucket(std::string_view key) { return _buckets[hash_key(key) & (_bucket_count - 1)]; }
+
+// See SlabLRU.h
+SlabLRU::item *SlabLRU::find(std::string_view key) {
+    for (item *it = item_at(bucket(key)); it != nullptr; it = item_at(it->chain)) {
+        if (it->key() == key) {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
+// See SlabLRU.h
+void SlabLRU::assign_page(std::size_t page_idx, int cls) {
+    page &p = _pages[page_idx];
+    p.slab_class = cls;
+    p.draining = 0;
+
+    slab_class &c = _classes[cls];
+    char *memory = page_memory(page_idx);
+    for (std::size_t offset = 0; offset + c.chunk_size <= _page_size; offset += c.chunk_size) {
+        item *it = reinterpret_cast<item *>(memory + offset);
+        it->chain = Unused;
+        it->next = c.free;
+        c.free = offset_of(it);
+    }
+    c.pages++;
+}
+
+// See SlabLRU.h
+void SlabLRU::link(slab_class &c, item *it) {
+    it->prev = 0;
+    it->next = c.head;
+    if (c.head != 0) {
+        item_at(c.head)->prev = offset_of(it);
+    }
+    c.head = offset_of(it);
+    if (c.tail == 0) {
+        c.tail = c.head;
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::unlink(slab_class &c, item *it) {
+    if (it->prev != 0) {
+        item_at(it->prev)->next = it->next;
+    } else {
+        c.head = it->next;
+    }
+
+    if (it->next != 0) {
+        item_at(it->next)->prev = it->prev;
+    } else {
+        c.tail = it->prev;
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::free_chunk(item *it) {
+    it->chain = Unused;
+    page &p = _pages[page_of(it)];
+    if (p.draining) {
+        return;
+    }
+
+    slab_class &c = _classes[p.slab_class];
+    it->next = c.free;
+    c.free = offset_of(it);
+}
+
+// See SlabLRU.h
+void SlabLRU::remove(item *it) {
+    uint64_t offset = offset_of(it);
+    uint64_t *chain = &bucket(it->key());
+    while (*chain != offset) {
+        chain = &item_at(*chain)->chain;
+    }
+    *chain = it->chain;
+
+    slab_class &c = class_of(it);
+    unlink(c, it);
+    c.items--;
+    _header->items--;
+    free_chunk(it);
+}
+
+// See SlabLRU.h
+SlabLRU::item *SlabLRU::alloc(int cls, const std::string &key, bool check_admission) {
+    slab_class &c = _classes[cls];
+    if (c.free == 0 && _header->free_pages > 0) {
+        for (std::size_t i = 0; i < _page_count; i++) {
+            if (_pages[i].slab_class < 0) {
+                assign_page(i, cls);
+                _header->free_pages--;
+                break;
+            }
+        }
+    }
+
+    if (c.free == 0 && c.tail != 0 && check_admission && _admission &&
+        !_admission->Admit(key, std::string(item_at(c.tail)->key()))) {
+        return nullptr;
+    }
+
+    // Evicted chunks from the draining page aren't reused, so it could take more than one
+    while (c.free == 0 && c.tail != 0) {
+        c.evictions++;
+        c.pressure++;
+        remove(item_at(c.tail));
+    }
+
+    if (c.free == 0) {
+        c.outofmemory++;
+        c.pressure++;
+        return nullptr;
+    }
+
+    item *it = item_at(c.free);
+    c.free = it->next;
+    return it;
+}
+
+// See SlabLRU.h
+bool SlabLRU::put(const std::string &key, const std::string &value, bool check_admission) {
+    int cls = find_class(key.size(), value.size());
+    if (cls < 0) {
+        return false;
+    }
+
+    item *it = alloc(cls, key, check_admission);
+    if (it == nullptr) {
+        return false;
+    }
+
+    it->key_size = key.size();
+    it->value_size = value.size();
+    std::memcpy(it->data(), key.data(), key.size());
+    std::memcpy(it->data() + key.size(), value.data(), value.size());
+
+    slab_class &c = _classes[cls];
+    link(c, it);
+    c.items++;
+    _header->items++;
+
+    uint64_t &head = bucket(it->key());
+    it->chain = head;
+    head = offset_of(it);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Put(const std::string &key, const std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::mutex> lock(_m);
+    return store(key, value);
+}
+
+// See SlabLRU.h
+bool SlabLRU::store(const std::string &key, const std::string &value) {
+    item *it = find(key);
+    if (it == nullptr) {
+        return put(key, value, true);
+    }
+
+    // Value too big for any class must not destroy the existing one
+    int new_cls = find_class(key.size(), value.size());
+    if (new_cls < 0) {
+        return false;
+    }
+
+    // Overwrite in place if new value fits into the same chunk
+    int cls = _pages[page_of(it)].slab_class;
+    if (new_cls == cls) {
+        std::memcpy(it->data() + it->key_size, value.data(), value.size());
+        it->value_size = value.size();
+
+        slab_class &c = _classes[cls];
+        unlink(c, it);
+        link(c, it);
+        return true;
+    }
+
+    remove(it);
+    return put(key, value, false);
+}
+
+// See SlabLRU.h
+bool SlabLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::mutex> lock(_m);
+    if (find(key) != nullptr) {
+        return false;
+    }
+    return put(key, value, true);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Set(const std::string &key, const std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    // Key must not be deleted between the check and the store, otherwise it would be created again
+    std::unique_lock<std::mutex> lock(_m);
+    if (find(key) == nullptr) {
+        return false;
+    }
+    return store(key, value);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_m);
+    item *it = find(key);
+    if (it == nullptr) {
+        return false;
+    }
+    remove(it);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Get(const std::string &key, std::string &value) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::mutex> lock(_m);
+    item *it = find(key);
+    if (it == nullptr) {
+        return false;
+    }
+
+    value.assign(it->data() + it->key_size, it->value_size);
+
+    slab_class &c = class_of(it);
+    unlink(c, it);
+    link(c, it);
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                       std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    if (_admission) {
+        std::string key;
+        for (auto &k : keys) {
+            key.assign(k);
+            _admission->Record(key);
+        }
+    }
+
+    // Chunks are spread over pages, so the first pass only probes the index and prefetches values found, the
+    // second one copies them out when they are in cache already
+    thread_local std::vector<item *> items;
+    items.assign(keys.size(), nullptr);
+
+    std::unique_lock<std::mutex> lock(_m);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        items[i] = find(keys[i]);
+        if (items[i] != nullptr) {
+            __builtin_prefetch(items[i]->data() + items[i]->key_size);
+        }
+    }
+
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        item *it = items[i];
+        if (it == nullptr) {
+            continue;
+        }
+
+        values[i].assign(it->data() + it->key_size, it->value_size);
+        found[i] = true;
+
+        slab_class &c = class_of(it);
+        unlink(c, it);
+        link(c, it);
+    }
+}
+
+// See SlabLRU.h
+bool SlabLRU::Update(const std::string &key, const Updater &update) {
+    if (_admission) {
+        _admission->Record(key);
+    }
+
+    std::unique_lock<std::mutex> lock(_m);
+    std::string current, updated;
+    item *it = find(key);
+    if (it != nullptr) {
+        current.assign(it->data() + it->key_size, it->value_size);
+    }
+
+    switch (update(it != nullptr ? &current : nullptr, updated)) {
+    case UpdateAction::Store:
+        return store(key, updated);
+    case UpdateAction::Remove:
+        if (it != nullptr) {
+            remove(it);
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::Freeze(const std::function<void()> &frozen) {
+    std::unique_lock<std::mutex> lock(_m);
+    frozen();
+}
+
+// See SlabLRU.h
+bool SlabLRU::Scan(const Visitor &visit) {
+    // Shared memory isn't copied on write by fork, so forked child would see it changing
+    if (_segment->shared()) {
+        return false;
+    }
+
+    // Classes have own LRU lists, each is passed from its tail
+    for (std::size_t i = 0; i < _class_count; i++) {
+        for (item *it = item_at(_classes[i].tail); it != nullptr; it = item_at(it->prev)) {
+            visit(it->key(), std::string_view(it->data() + it->key_size, it->value_size));
+        }
+    }
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::unique_lock<std::mutex> lock(_m);
+
+    // Items take whole chunks, so bytes are counted by chunks in use
+    std::size_t bytes = 0, evictions = 0;
+    for (std::size_t i = 0; i < _class_count; i++) {
+        bytes += _classes[i].items * _classes[i].chunk_size;
+        evictions += _classes[i].evictions;
+    }
+    stats.emplace_back("curr_items", std::to_string(_header->items));
+    stats.emplace_back("bytes", std::to_string(bytes));
+    stats.emplace_back("evictions", std::to_string(evictions));
+    stats.emplace_back("limit_maxbytes", std::to_string(_page_count * _page_size));
+
+    stats.emplace_back("slab_total_pages", std::to_string(_page_count));
+    stats.emplace_back("slab_free_pages", std::to_string(_header->free_pages));
+    stats.emplace_back("slab_reassign_count", std::to_string(_header->reassign_count));
+    stats.emplace_back("slab_reassign_last_src", std::to_string(_header->reassign_last_src));
+    stats.emplace_back("slab_reassign_last_dst", std::to_string(_header->reassign_last_dst));
+    stats.emplace_back("slab_segment_attached", std::to_string(_attached ? 1 : 0));
+
+    for (std::size_t i = 0; i < _class_count; i++) {
+        slab_class &c = _classes[i];
+        if (c.pages == 0 && c.evictions == 0 && c.outofmemory == 0) {
+            continue;
+        }
+
+        std::string prefix = "slab_" + std::to_string(i) + ":";
+        stats.emplace_back(prefix + "chunk_size", std::to_string(c.chunk_size));
+        stats.emplace_back(prefix + "total_pages", std::to_string(c.pages));
+        stats.emplace_back(prefix + "used_chunks", std::to_string(c.items));
+        stats.emplace_back(prefix + "evictions", std::to_string(c.evictions));
+        stats.emplace_back(prefix + "outofmemory", std::to_string(c.outofmemory));
+    }
+}
+
+// See SlabLRU.h
+bool SlabLRU::Rebalance() {
+    std::size_t page_idx = _page_count;
+    int dst = -1;
+    {
+        std::unique_lock<std::mutex> lock(_m);
+
+        // Memory is still available for everyone, nothing to rebalance. Otherwise move page from the class
+        // without pressure having most pages to the class with the highest pressure
+        int src = -1;
+        if (_header->free_pages == 0) {
+            for (std::size_t i = 0; i < _class_count; i++) {
+                if (_classes[i].pressure > 0 && (dst < 0 || _classes[i].pressure > _classes[dst].pressure)) {
+                    dst = i;
+                }
+            }
+            for (std::size_t i = 0; dst >= 0 && i < _class_count; i++) {
+                if (_classes[i].pressure == 0 && _classes[i].pages > 0 &&
+                    (src < 0 || _classes[i].pages > _classes[src].pages)) {
+                    src = i;
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < _class_count; i++) {
+            _classes[i].pressure = 0;
+        }
+
+        if (src < 0 || dst < 0) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < _page_count; i++) {
+            if (_pages[i].slab_class == src && !_pages[i].draining) {
+                page_idx = i;
+                break;
+            }
+        }
+        if (page_idx == _page_count) {
+            return false;
+        }
+
+        // From now on page chunks are never given out, drop the free ones
+        _pages[page_idx].draining = 1;
+        slab_class &c = _classes[src];
+        c.pages--;
+
+        uint64_t *pfree = &c.free;
+        while (*pfree != 0) {
+            item *it = item_at(*pfree);
+            if (page_of(it) == page_idx) {
+                *pfree = it->next;
+            } else {
+                pfree = &it->next;
+            }
+        }
+
+        _header->reassign_last_src = src;
+        _header->reassign_last_dst = dst;
+    }
+
+    move_page(page_idx, dst);
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::move_page(std::size_t page_idx, int dst) {
+    page &p = _pages[page_idx];
+    std::size_t chunk_size = _classes[p.slab_class].chunk_size;
+    std::size_t chunks = _page_size / chunk_size;
+
+    for (std::size_t start = 0; start < chunks; start += move_batch) {
+        std::unique_lock<std::mutex> lock(_m);
+        for (std::size_t i = start; i < std::min(chunks, start + move_batch); i++) {
+            item *it = reinterpret_cast<item *>(page_memory(page_idx) + i * chunk_size);
+            if (it->used()) {
+                remove(it);
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(_m);
+    assign_page(page_idx, dst);
+    _header->reassign_count++;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,264 @@
+#ifndef AFINA_STORAGE_SLAB_LRU_H
+#define AFINA_STORAGE_SLAB_LRU_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "AdmissionPolicy.h"
+#include "Segment.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU on top of slab allocator
+ * Storage memory is divided onto pages of the same size, each page is assigned to some slab class and sliced onto
+ * chunks of the class size. Item is stored in the smallest chunk it fits, class sizes grow by factor 1.25.
+ *
+ * Each class has its own LRU list, so if there are no free chunk in the class then least recently used item of the
+ * same class gets evicted, so burst of large values can't push small ones out.
+ *
+ * Classes are getting pages on demand until all memory is used. After that background rebalancer, running between
+ * Start and Stop calls, periodically moves one page from the class that had no evictions to the one that had the
+ * most evictions since last check. Page items are evicted in small batches, releasing lock in between, so request
+ * threads are not blocked for the whole page move.
+ *
+ * All the state, pages, index and class lists, lives in a single memory segment and refers to itself by offsets
+ * from the segment start. Segment could be named shared memory: it outlives the process and the next process
+ * created with the same name and sizes attaches to the items left there, so cache stays hot across restarts and
+ * upgrades without any serialization. Storage marks segment consistent once it is destroyed, segment left by a
+ * process that has crashed is reinitialized. Layout depends only on sizes and the header structures, binary that
+ * changes them must change the segment magic.
+ *
+ * That is thread safe implementation
+ */
+class SlabLRU : public Afina::Storage {
+public:
+    /**
+     * @param max_size of memory for items, rounded down to the page size
+     * @param page_size of memory moved between classes at once
+     * @param admission optional admission filter
+     * @param segment name of the shared memory to keep data in, like "/afina", or empty to keep it private. Throws
+     * std::runtime_error if segment can't be mapped
+     */
+    SlabLRU(size_t max_size = 64 * 1024 * 1024, size_t page_size = 1024 * 1024,
+            std::shared_ptr<AdmissionPolicy> admission = nullptr, const std::string &segment = std::string());
+    ~SlabLRU();
+
+    /**
+     * Returns true if storage has attached to items left in shared memory segment by previous process
+     */
+    inline bool Attached() const { return _attached; }
+
+    // Starts rebalancer thread
+    void Start() override;
+
+    // Stops rebalancer thread
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Update(const std::string &key, const Updater &update) override;
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override;
+
+    // Implements Afina::Storage interface
+    void Freeze(const std::function<void()> &frozen) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Visitor &visit) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Runs single rebalancer pass: moves at most one page between classes. Returns true if page was moved
+     */
+    bool Rebalance();
+
+private:
+    // Everything below is stored in the segment, references are offsets from the segment start and 0 means none
+
+    // Start of the segment
+    struct header {
+        char magic[8];
+
+        // Layout of the segment, attached segment must have the same
+        uint64_t size;
+        uint64_t page_size;
+        uint64_t pages;
+        uint64_t buckets;
+
+        // Set once storage is destroyed, so data is consistent
+        uint64_t clean;
+
+        uint64_t items;
+        uint64_t free_pages;
+
+        // Rebalancer decisions
+        uint64_t reassign_count;
+        int64_t reassign_last_src;
+        int64_t reassign_last_dst;
+    };
+
+    // Index chain of the chunk that isn't used
+    static constexpr uint64_t Unused = ~uint64_t(0);
+
+    // Header of the chunk, key and value bytes follow it
+    struct item {
+        // LRU list of the class if chunk is used, free list otherwise
+        uint64_t prev;
+        uint64_t next;
+
+        // Next item in the same index bucket, Unused if chunk isn't used
+        uint64_t chain;
+
+        uint32_t key_size;
+        uint32_t value_size;
+
+        inline bool used() const { return chain != Unused; }
+        inline char *data() { return reinterpret_cast<char *>(this + 1); }
+        inline std::string_view key() { return std::string_view(data(), key_size); }
+    };
+
+    struct slab_class {
+        uint64_t chunk_size;
+
+        // Free chunks, linked by item::next
+        uint64_t free;
+
+        // LRU list, head is the most recent one
+        uint64_t head;
+        uint64_t tail;
+
+        uint64_t pages;
+        uint64_t items;
+        uint64_t evictions;
+
+        // Number of failed allocations: no free chunks and nothing to evict
+        uint64_t outofmemory;
+
+        // evictions + outofmemory since last rebalancer check
+        uint64_t pressure;
+    };
+
+    struct page {
+        int32_t slab_class;
+
+        // Page is on the way to another class, its chunks must not be reused
+        uint32_t draining;
+    };
+
+    inline item *item_at(uint64_t offset) const {
+        return offset == 0 ? nullptr : reinterpret_cast<item *>(_base + offset);
+    }
+
+    inline uint64_t offset_of(item *it) const { return it == nullptr ? 0 : reinterpret_cast<char *>(it) - _base; }
+
+    inline char *page_memory(std::size_t page_idx) const { return _memory + page_idx * _page_size; }
+
+    inline std::size_t page_of(item *it) const { return (reinterpret_cast<char *>(it) - _memory) / _page_size; }
+
+    inline slab_class &class_of(item *it) const { return _classes[_pages[page_of(it)].slab_class]; }
+
+    // Returns index bucket of the key
+    uint64_t &bucket(std::string_view key);
+
+    // Returns item stored for the key or nullptr
+    item *find(std::string_view key);
+
+    // Fills segment with empty storage
+    void initialize(const std::vector<std::size_t> &chunk_sizes);
+
+    // Returns class for the item of given size or -1 if it is too big
+    int find_class(std::size_t key_size, std::size_t value_size) const;
+
+    // Slices page onto chunks of the given class
+    void assign_page(std::size_t page_idx, int cls);
+
+    // Returns new chunk, evicting class items if needed, or nullptr if class has no memory or admission policy
+    // rejects the key
+    item *alloc(int cls, const std::string &key, bool check_admission);
+
+    void free_chunk(item *it);
+
+    void link(slab_class &c, item *it);
+
+    void unlink(slab_class &c, item *it);
+
+    void remove(item *it);
+
+    // Stores item, caller must ensure key isn't present
+    bool put(const std::string &key, const std::string &value, bool check_admission);
+
+    // Stores item replacing existing one if any
+    bool store(const std::string &key, const std::string &value);
+
+    // Moves page between classes, takes lock by itself
+    void move_page(std::size_t page_idx, int dst);
+
+    // Background thread function
+    void OnRun();
+
+    const std::size_t _page_size;
+
+    // Memory all the state lives in, the rest are pointers into it
+    std::unique_ptr<Segment> _segment;
+    bool _attached;
+    char *_base;
+    header *_header;
+
+    // Classes sorted by chunk size
+    slab_class *_classes;
+    std::size_t _class_count;
+
+    // Pages, their memory is allocated on first use
+    page *_pages;
+    std::size_t _page_count;
+    char *_memory;
+
+    // Index of items: chains of items linked by item::chain, keys are owned by chunks
+    uint64_t *_buckets;
+    std::size_t _bucket_count;
+
+    // Optional admission filter, could be nullptr
+    std::shared_ptr<AdmissionPolicy> _admission;
+
+    // Protects everything above
+    std::mutex _m;
+
+    // Rebalancer thread and its stop signal
+    std::thread _rebalancer;
+    std::mutex _rebalancer_mutex;
+    std::condition_variable _rebalancer_cv;
+    bool _running;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_LRU_H
@@ -0,0 +1,242 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+constexpr char Snapshot::Magic[8];
+
+// Loading threads report progress once they have stored that many items
+static const std::size_t progress_batch = 4096;
+
+// Closes file unless it has been closed explicitly
+struct file_closer {
+    void operator()(std::FILE *f) const { std::fclose(f); }
+};
+
+// Read-only mapping of the whole file, unmapped on destruction
+struct file_mapping {
+    const char *data = nullptr;
+    std::size_t size = 0;
+
+    ~file_mapping() {
+        if (data != nullptr) {
+            munmap(const_cast<char *>(data), size);
+        }
+    }
+};
+
+// Runs work in the given number of threads including the calling one, returns once all of them are done
+static void run_parallel(std::size_t threads, const std::function<void()> &work) {
+    std::vector<std::thread> helpers;
+    for (std::size_t i = 1; i < threads; i++) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+}
+
+// See Snapshot.h
+bool Snapshot::Write(Storage &storage, const std::string &path, std::size_t &items) {
+    items = 0;
+    std::string tmp_path = path + ".tmp";
+    std::unique_ptr<std::FILE, file_closer> file(std::fopen(tmp_path.c_str(), "wb"));
+    if (!file) {
+        return false;
+    }
+
+    // Items are small, so writes are batched by stdio in large buffer
+    std::setvbuf(file.get(), nullptr, _IOFBF, 1 << 20);
+
+    uint64_t offset = sizeof(Magic), next_chunk = offset;
+    std::vector<uint64_t> chunks;
+    bool ok = std::fwrite(Magic, sizeof(Magic), 1, file.get()) == 1;
+    bool scanned = storage.Scan([&](std::string_view key, std::string_view value) {
+        if (offset >= next_chunk) {
+            chunks.push_back(offset);
+            next_chunk = offset + ChunkSize;
+        }
+
+        uint32_t sizes[2] = {uint32_t(key.size()), uint32_t(value.size())};
+        ok = ok && std::fwrite(sizes, sizeof(sizes), 1, file.get()) == 1 &&
+             std::fwrite(key.data(), 1, key.size(), file.get()) == key.size() &&
+             std::fwrite(value.data(), 1, value.size(), file.get()) == value.size();
+        offset += sizeof(sizes) + key.size() + value.size();
+        items++;
+    });
+
+    uint32_t end[2] = {EndMark, 0};
+    uint64_t footer[2] = {chunks.size(), items};
+    ok = ok && scanned && std::fwrite(end, sizeof(end), 1, file.get()) == 1 &&
+         std::fwrite(chunks.data(), sizeof(uint64_t), chunks.size(), file.get()) == chunks.size() &&
+         std::fwrite(footer, sizeof(footer), 1, file.get()) == 1;
+
+    // Data must be on disk before rename makes it the snapshot
+    ok = ok && std::fflush(file.get()) == 0 && fsync(fileno(file.get())) == 0;
+    ok = (std::fclose(file.release()) == 0) && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// See Snapshot.h
+bool Snapshot::Load(Storage &storage, const std::string &path, std::size_t threads, std::size_t &items,
+                    const Progress &progress) {
+    items = 0;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno == ENOENT;
+    }
+
+    // Mapping keeps file alive, so descriptor isn't needed once file is mapped
+    file_mapping file;
+    struct stat st;
+    uint64_t footer[2];
+    const std::size_t min_size = sizeof(Magic) + 2 * sizeof(uint32_t) + sizeof(footer);
+    if (fstat(fd, &st) == 0 && std::size_t(st.st_size) >= min_size) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file.data = static_cast<const char *>(data);
+            file.size = st.st_size;
+        }
+    }
+    close(fd);
+    if (file.data == nullptr) {
+        return false;
+    }
+
+    // Pages are read in by many threads at once, let kernel start reading ahead right away
+    madvise(const_cast<char *>(file.data), file.size, MADV_WILLNEED);
+
+    // Footer tells where chunk table and end of items are, both must be consistent with the file size
+    std::memcpy(footer, file.data + file.size - sizeof(footer), sizeof(footer));
+    const uint64_t chunk_count = footer[0], total = footer[1];
+    if (std::memcmp(file.data, Magic, sizeof(Magic)) != 0 ||
+        chunk_count > (file.size - min_size) / sizeof(uint64_t)) {
+        return false;
+    }
+
+    const uint64_t end = file.size - sizeof(footer) - chunk_count * sizeof(uint64_t) - 2 * sizeof(uint32_t);
+    uint32_t end_mark[2];
+    std::memcpy(end_mark, file.data + end, sizeof(end_mark));
+    if (end_mark[0] != EndMark || end_mark[1] != 0) {
+        return false;
+    }
+
+    std::vector<uint64_t> chunks(chunk_count + 1);
+    std::memcpy(chunks.data(), file.data + end + sizeof(end_mark), chunk_count * sizeof(uint64_t));
+    chunks[chunk_count] = end;
+    for (std::size_t c = 0; c < chunk_count; c++) {
+        if (chunks[c] >= chunks[c + 1]) {
+            return false;
+        }
+    }
+    if (chunks[0] != (chunk_count > 0 ? sizeof(Magic) : end)) {
+        return false;
+    }
+
+    // Stage 1: chunks are parsed in parallel, offsets of items are grouped by storage partition. Offsets are kept
+    // relative to the chunk start, every item of well formed file starts less than ChunkSize after its chunk
+    const std::size_t partitions = storage.Partitions();
+    std::vector<std::vector<std::vector<uint32_t>>> parsed(chunk_count);
+    std::atomic<std::size_t> next_chunk(0);
+    std::atomic<uint64_t> parsed_items(0);
+    std::atomic<bool> malformed(false);
+    threads = std::max<std::size_t>(1, threads);
+
+    run_parallel(std::min<std::size_t>(threads, chunk_count), [&]() {
+        for (std::size_t c = next_chunk++; c < chunk_count && !malformed; c = next_chunk++) {
+            auto &lanes = parsed[c];
+            lanes.resize(partitions);
+            uint64_t count = 0, p = chunks[c];
+            while (p < chunks[c + 1]) {
+                uint32_t sizes[2];
+                if (chunks[c + 1] - p < sizeof(sizes)) {
+                    break;
+                }
+                std::memcpy(sizes, file.data + p, sizeof(sizes));
+                uint64_t next = p + sizeof(sizes) + uint64_t(sizes[0]) + sizes[1];
+                if (sizes[0] == EndMark || next > chunks[c + 1] ||
+                    p - chunks[c] > std::numeric_limits<uint32_t>::max()) {
+                    break;
+                }
+                std::string_view key(file.data + p + sizeof(sizes), sizes[0]);
+                lanes[storage.Partition(key)].push_back(uint32_t(p - chunks[c]));
+                count++;
+                p = next;
+            }
+            if (p != chunks[c + 1]) {
+                malformed = true;
+            }
+            parsed_items += count;
+        }
+    });
+    if (malformed || parsed_items != total) {
+        return false;
+    }
+
+    // Stage 2: each partition is filled by a single thread, chunks go in file order, so partition gets its items
+    // from the least recently used one
+    std::atomic<std::size_t> next_partition(0), loaded(0), stored(0);
+    std::atomic<bool> stopped(false);
+    run_parallel(std::min(threads, partitions), [&]() {
+        std::size_t batch = 0, own_stored = 0;
+        for (std::size_t l = next_partition++; l < partitions && !stopped; l = next_partition++) {
+            for (std::size_t c = 0; c < chunk_count && !stopped; c++) {
+                for (uint32_t offset : parsed[c][l]) {
+                    const char *record = file.data + chunks[c] + offset;
+                    uint32_t sizes[2];
+                    std::memcpy(sizes, record, sizeof(sizes));
+                    std::string key(record + sizeof(sizes), sizes[0]);
+                    std::string value(record + sizeof(sizes) + sizes[0], sizes[1]);
+                    if (storage.PutIfAbsent(key, value)) {
+                        own_stored++;
+                    }
+
+                    if (++batch == progress_batch) {
+                        std::size_t now_loaded = (loaded += batch);
+                        batch = 0;
+                        if (progress && !progress(now_loaded, total)) {
+                            stopped = true;
+                        }
+                        if (stopped) {
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        loaded += batch;
+        stored += own_stored;
+    });
+
+    items = stored;
+    if (stopped) {
+        return false;
+    }
+    if (progress) {
+        progress(loaded, total);
+    }
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
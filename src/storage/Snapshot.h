@@ -0,0 +1,79 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage snapshot file
+ * Compact binary dump of all storage items in the order Storage::Scan passes them, so that storing them back one by
+ * one restores recency order. Values are stored as is, including item header, so items keep their flags, CAS and
+ * absolute expiration time across restart.
+ *
+ * Layout, numbers are in host byte order:
+ * - header: 8 bytes magic "AFNSNAP1"
+ * - item: uint32 key size, uint32 value size, key bytes, value bytes
+ * - end of items: uint32 0xFFFFFFFF, uint32 0
+ * - chunk table: uint64 offset of the first item of each chunk, new chunk starts once ChunkSize bytes of items have
+ *   been written since the previous one, so that items could be parsed by several threads at once
+ * - footer: uint64 number of chunks, uint64 number of items, so that truncated file is detected
+ *
+ * File is written under temporary name and renamed once complete, so there is either the previous snapshot or the
+ * new one at the path
+ */
+class Snapshot {
+public:
+    static constexpr char Magic[8] = {'A', 'F', 'N', 'S', 'N', 'A', 'P', '1'};
+
+    // Key size of the end of items record
+    static constexpr uint32_t EndMark = 0xFFFFFFFF;
+
+    // Approximate size of the chunk of items parsed by a single thread
+    static constexpr uint64_t ChunkSize = 4 << 20;
+
+    /**
+     * Gets number of items loaded so far and total number of items in the snapshot, returns false to stop loading
+     */
+    using Progress = std::function<bool(std::size_t loaded, std::size_t total)>;
+
+    /**
+     * Writes all items of the storage into file. Storage is scanned without locks, see Storage::Scan for when it
+     * is safe. Returns false if storage can't be scanned or file can't be written
+     *
+     * @param storage to dump
+     * @param path of the snapshot file
+     * @param items output parameter, number of items written
+     */
+    static bool Write(Storage &storage, const std::string &path, std::size_t &items);
+
+    /**
+     * Maps snapshot file into memory and stores its items into the storage. Chunks are parsed and split by storage
+     * partitions in parallel, then each partition is filled by a single thread in the file order, so its recency
+     * order is restored exactly while different partitions are filled concurrently.
+     *
+     * Items are stored by PutIfAbsent, so whatever clients have written wins over the snapshot. Key deleted by a
+     * client is absent though, so storage served while loading must be LoadingStorage, which keeps such keys from
+     * coming back. Missing file is loaded as an empty snapshot. Returns false if file is malformed or loading has
+     * been stopped by progress callback
+     *
+     * @param storage to fill
+     * @param path of the snapshot file
+     * @param threads number of threads to parse and store items with
+     * @param items output parameter, number of items stored
+     * @param progress called by loading threads every few thousand items, could be empty
+     */
+    static bool Load(Storage &storage, const std::string &path, std::size_t threads, std::size_t &items,
+                     const Progress &progress = Progress());
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
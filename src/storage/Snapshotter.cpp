@@ -0,0 +1,112 @@
+#include "Snapshotter.h"
+
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Snapshot.h"
+
+namespace Afina {
+namespace Backend {
+
+// See Snapshotter.h
+Snapshotter::Snapshotter(std::shared_ptr<Storage> storage, const std::string &path, std::chrono::seconds interval,
+                         const Done &done)
+    : _storage(storage), _path(path), _interval(interval), _done(done), _requested(false), _running(false) {}
+
+// See Snapshotter.h
+Snapshotter::~Snapshotter() { Stop(); }
+
+// See Snapshotter.h
+void Snapshotter::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        _running = true;
+        _thread = std::thread(&Snapshotter::OnRun, this);
+    }
+}
+
+// See Snapshotter.h
+void Snapshotter::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Snapshotter.h
+void Snapshotter::Request() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _requested = true;
+    }
+    _cv.notify_all();
+}
+
+// See Snapshotter.h
+bool Snapshotter::Take() {
+    std::unique_lock<std::mutex> lock(_take_mutex);
+    auto started = std::chrono::steady_clock::now();
+
+    // Child is forked with all storage locks held, so its copy of storage is consistent and nobody in the child
+    // could ever release them. Child never returns from here: it scans storage without locks and exits
+    pid_t pid = -1;
+    _storage->Freeze([&]() {
+        pid = fork();
+        if (pid == 0) {
+            std::size_t items;
+            _exit(Snapshot::Write(*_storage, _path, items) ? 0 : 1);
+        }
+    });
+
+    bool ok = false;
+    if (pid > 0) {
+        int status;
+        pid_t waited;
+        while ((waited = waitpid(pid, &status, 0)) == -1 && errno == EINTR) {
+            continue;
+        }
+        ok = (waited == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    if (_done) {
+        _done(ok, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started));
+    }
+    return ok;
+}
+
+// See Snapshotter.h
+void Snapshotter::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto next = std::chrono::steady_clock::now() + _interval;
+    while (_running) {
+        if (_interval.count() > 0) {
+            _cv.wait_until(lock, next, [this] { return _requested || !_running; });
+        } else {
+            _cv.wait(lock, [this] { return _requested || !_running; });
+        }
+        if (!_running) {
+            break;
+        }
+
+        bool periodic = _interval.count() > 0 && std::chrono::steady_clock::now() >= next;
+        if (_requested || periodic) {
+            _requested = false;
+            lock.unlock();
+            Take();
+            lock.lock();
+
+            // Interval is counted from the end of the last snapshot, whatever has triggered it
+            next = std::chrono::steady_clock::now() + _interval;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
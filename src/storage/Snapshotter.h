@@ -0,0 +1,82 @@
+#ifndef AFINA_STORAGE_SNAPSHOTTER_H
+#define AFINA_STORAGE_SNAPSHOTTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Background snapshot taker
+ * Takes snapshots of the storage into file, see Snapshot.h, on request and periodically. Process is forked while
+ * storage is frozen, so child gets copy-on-write image of the storage consistent at a single point in time and
+ * writes it to disk, while parent keeps serving requests. Request threads wait only while fork copies page tables,
+ * all disk I/O happens in the child and the parent side waits for it in the background thread.
+ *
+ * Requests which come while snapshot is in progress are merged into the single next snapshot
+ */
+class Snapshotter {
+public:
+    /**
+     * Gets result of each snapshot: whether it succeeded and how long it took
+     */
+    using Done = std::function<void(bool ok, std::chrono::milliseconds duration)>;
+
+    /**
+     * @param storage to take snapshots of
+     * @param path of the snapshot file
+     * @param interval between periodic snapshots, zero if snapshots are taken on request only
+     * @param done called from the background thread once snapshot is finished, could be empty
+     */
+    Snapshotter(std::shared_ptr<Storage> storage, const std::string &path, std::chrono::seconds interval,
+                const Done &done = Done());
+    ~Snapshotter();
+
+    // Starts background thread
+    void Start();
+
+    // Stops background thread, waits for the snapshot in progress if any
+    void Stop();
+
+    /**
+     * Asks background thread to take snapshot as soon as possible, doesn't wait for it
+     */
+    void Request();
+
+    /**
+     * Takes snapshot in the calling thread, waits until child process finishes. Returns true if snapshot is written
+     */
+    bool Take();
+
+private:
+    // Background thread function
+    void OnRun();
+
+    std::shared_ptr<Storage> _storage;
+    const std::string _path;
+    const std::chrono::seconds _interval;
+    Done _done;
+
+    // Only one child could write snapshot at a time
+    std::mutex _take_mutex;
+
+    // Background thread, its requests and stop signal
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _requested;
+    bool _running;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOTTER_H
@@ -0,0 +1,104 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_CLOCK_H
+#define AFINA_STORAGE_THREAD_SAFE_CLOCK_H
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "SimpleClock.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleClock thread safe version
+ * Get only sets reference bit on hit, so readers share the lock
+ */
+class ThreadSafeClock : public SimpleClock {
+public:
+    ThreadSafeClock(size_t max_size = 1024, bool scan_resistant = false,
+                    std::shared_ptr<AdmissionPolicy> admission = nullptr)
+        : SimpleClock(max_size, scan_resistant, admission) {}
+    ~ThreadSafeClock() {}
+
+    // see SimpleClock.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Put(key, value);
+    }
+
+    // see SimpleClock.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::PutIfAbsent(key, value);
+    }
+
+    // see SimpleClock.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Set(key, value);
+    }
+
+    // see SimpleClock.h
+    bool Delete(const std::string &key) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Delete(key);
+    }
+
+    // see SimpleClock.h
+    bool Get(const std::string &key, std::string &value) override {
+        std::shared_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Get(key, value);
+    }
+
+    // see SimpleClock.h
+    bool Update(const std::string &key, const Updater &update) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Update(key, update);
+    }
+
+    // see SimpleClock.h
+    bool Add(const std::string &key, const std::string &value, const Check &present) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Add(key, value, present);
+    }
+
+    // see SimpleClock.h
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Replace(key, value, present);
+    }
+
+    // see SimpleClock.h
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        return SimpleClock::Insert(key, data, offset, patch);
+    }
+
+    // see SimpleClock.h
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override {
+        std::shared_lock<std::shared_mutex> lock(_m);
+        SimpleClock::MultiGet(keys, values, found);
+    }
+
+    // see SimpleClock.h
+    void Freeze(const std::function<void()> &frozen) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        frozen();
+    }
+
+    // see SimpleClock.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::unique_lock<std::shared_mutex> lock(_m);
+        SimpleClock::Stats(stats);
+    }
+
+private:
+    std::shared_mutex _m;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_CLOCK_H
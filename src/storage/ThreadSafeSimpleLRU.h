@@ -17,7 +17,8 @@ namespace Backend {
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, std::shared_ptr<AdmissionPolicy> admission = nullptr)
+        : SimpleLRU(max_size, admission) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
@@ -50,6 +51,49 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Update(const std::string &key, const Updater &update) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        return SimpleLRU::Update(key, update);
+    }
+
+    // see SimpleLRU.h
+    bool Add(const std::string &key, const std::string &value, const Check &present) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        return SimpleLRU::Add(key, value, present);
+    }
+
+    // see SimpleLRU.h
+    bool Replace(const std::string &key, const std::string &value, const Check &present) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        return SimpleLRU::Replace(key, value, present);
+    }
+
+    // see SimpleLRU.h
+    bool Insert(const std::string &key, const std::string &data, std::size_t offset, const Patch &patch) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        return SimpleLRU::Insert(key, data, offset, patch);
+    }
+
+    // see SimpleLRU.h
+    void MultiGet(const std::vector<std::string_view> &keys, std::vector<std::string> &values,
+                  std::vector<bool> &found) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        SimpleLRU::MultiGet(keys, values, found);
+    }
+
+    // see SimpleLRU.h
+    void Freeze(const std::function<void()> &frozen) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        frozen();
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::unique_lock<std::recursive_mutex> lock(_m);
+        SimpleLRU::Stats(stats);
+    }
+
 private:
     std::recursive_mutex _m;
 };
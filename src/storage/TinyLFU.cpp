@@ -0,0 +1,60 @@
+#include "TinyLFU.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See TinyLFU.h
+TinyLFU::TinyLFU(std::size_t items) : _width(16), _samples(0) {
+    while (_width < items) {
+        _width <<= 1;
+    }
+    _sample_size = 10 * _width;
+
+    _sketch.reset(new std::atomic<uint8_t>[sketch_depth * _width]);
+    for (std::size_t i = 0; i < sketch_depth * _width; i++) {
+        _sketch[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// See TinyLFU.h
+uint8_t TinyLFU::frequency(std::size_t hash) const {
+    uint8_t result = max_frequency;
+    for (std::size_t row = 0; row < sketch_depth; row++) {
+        result = std::min(result, _sketch[counter(hash, row)].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+// See TinyLFU.h
+void TinyLFU::age() {
+    for (std::size_t i = 0; i < sketch_depth * _width; i++) {
+        _sketch[i].store(_sketch[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+    }
+}
+
+// See TinyLFU.h
+void TinyLFU::Record(const std::string &key) {
+    std::size_t hash = std::hash<std::string>()(key);
+    for (std::size_t row = 0; row < sketch_depth; row++) {
+        std::atomic<uint8_t> &c = _sketch[counter(hash, row)];
+        uint8_t v = c.load(std::memory_order_relaxed);
+        while (v < max_frequency && !c.compare_exchange_weak(v, v + 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Concurrent aging is not a problem: counters are approximate anyway
+    if (_samples.fetch_add(1, std::memory_order_relaxed) + 1 == _sample_size) {
+        age();
+        _samples.fetch_sub(_sample_size / 2, std::memory_order_relaxed);
+    }
+}
+
+// See TinyLFU.h
+bool TinyLFU::Admit(const std::string &candidate, const std::string &victim) {
+    return Frequency(candidate) > Frequency(victim);
+}
+
+} // namespace Backend
+} // namespace Afina
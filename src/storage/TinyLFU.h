@@ -0,0 +1,73 @@
+#ifndef AFINA_STORAGE_TINY_LFU_H
+#define AFINA_STORAGE_TINY_LFU_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "AdmissionPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # TinyLFU admission policy
+ * Keeps approximate access frequency of keys in count-min sketch with 4-bit saturating counters. Once number of
+ * recorded accesses reaches 10 times of sketch width all counters get halved, so frequencies are of the recent past.
+ *
+ * New key is admitted only if it was accessed more often than the victim, on tie victim stays. There is no window
+ * segment of W-TinyLFU: backends keep a single recency order, so new key competes with the victim right away instead
+ * of living in a small LRU window first. Misses are recorded as well, so key that becomes popular gains frequency by
+ * its misses before it is offered, while keys of a scan, even a repeated one, stay less frequent than the hot ones
+ */
+class TinyLFU : public AdmissionPolicy {
+public:
+    /**
+     * @param items number of items cache is expected to hold, sketch has a counter per item in each row
+     */
+    TinyLFU(std::size_t items = 1024);
+    ~TinyLFU() {}
+
+    // See AdmissionPolicy.h
+    void Record(const std::string &key) override;
+
+    // See AdmissionPolicy.h
+    bool Admit(const std::string &candidate, const std::string &victim) override;
+
+    /**
+     * Returns estimated number of accesses for the given key
+     */
+    uint8_t Frequency(const std::string &key) const { return frequency(std::hash<std::string>()(key)); }
+
+private:
+    static constexpr std::size_t sketch_depth = 4;
+    static constexpr uint8_t max_frequency = 15;
+
+    inline std::size_t counter(std::size_t hash, std::size_t row) const {
+        uint64_t x = (hash + row) * 0x9E3779B97F4A7C15ULL;
+        x ^= x >> 29;
+        return row * _width + (x & (_width - 1));
+    }
+
+    uint8_t frequency(std::size_t hash) const;
+
+    // Halves all counters
+    void age();
+
+    // Number of counters in each row, power of 2
+    std::size_t _width;
+
+    // Number of accesses to be recorded before aging
+    std::size_t _sample_size;
+    std::atomic<std::size_t> _samples;
+
+    // Count-min sketch: sketch_depth rows of _width counters each
+    std::unique_ptr<std::atomic<uint8_t>[]> _sketch;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TINY_LFU_H
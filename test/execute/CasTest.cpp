@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <afina/execute/Arithmetic.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+
+// Returns CAS unique reported by gets for a single key
+static std::string Gets(Storage &storage, std::string_view key) {
+    std::vector<std::string_view> keys = {key};
+    Execute::Get gets(keys, true);
+    std::string out;
+    gets.Execute(storage, "", out);
+    return out;
+}
+
+static std::string Counter(Storage &storage, const std::string &key, uint64_t delta, bool decrement) {
+    Execute::Arithmetic command(key, delta, decrement);
+    std::string out;
+    command.Execute(storage, "", out);
+    return out;
+}
+
+TEST(CasTest, CheckAndSet) {
+    Backend::SimpleLRU storage;
+    std::string out;
+
+    Execute::Cas cas("foo", 0, 0, 1);
+    cas.Execute(storage, "bar", out);
+    EXPECT_EQ("NOT_FOUND", out);
+
+    Execute::Set set("foo", 5, 0);
+    set.Execute(storage, "bar", out);
+
+    // VALUE foo 5 3 <cas>
+    std::string reply = Gets(storage, "foo");
+    ASSERT_EQ(0, reply.find("VALUE foo 5 3 "));
+    uint64_t unique = std::stoull(reply.substr(14));
+
+    cas.Assign("foo", 7, 0, unique + 1);
+    cas.Execute(storage, "baz", out);
+    EXPECT_EQ("EXISTS", out);
+
+    cas.Assign("foo", 7, 0, unique);
+    cas.Execute(storage, "baz", out);
+    EXPECT_EQ("STORED", out);
+
+    // Item has got new unique, so the same request fails now
+    cas.Execute(storage, "qux", out);
+    EXPECT_EQ("EXISTS", out);
+
+    reply = Gets(storage, "foo");
+    ASSERT_EQ(0, reply.find("VALUE foo 7 3 "));
+    EXPECT_NE(unique, std::stoull(reply.substr(14)));
+    EXPECT_EQ("baz\r\nEND", reply.substr(reply.find("\r\n") + 2));
+}
+
+TEST(CasTest, IncrDecr) {
+    Backend::SimpleLRU storage;
+    std::string out;
+
+    EXPECT_EQ("NOT_FOUND", Counter(storage, "n", 1, false));
+
+    Execute::Set set("n", 3, 0);
+    set.Execute(storage, "10", out);
+    EXPECT_EQ("15", Counter(storage, "n", 5, false));
+    EXPECT_EQ("0", Counter(storage, "n", 20, true));
+    EXPECT_EQ("18446744073709551615", Counter(storage, "n", 18446744073709551615ull, false));
+    EXPECT_EQ("1", Counter(storage, "n", 2, false));
+
+    // Flags are kept, data length follows the number
+    std::vector<std::string_view> keys = {"n"};
+    Execute::Get get(keys);
+    get.Execute(storage, "", out);
+    EXPECT_EQ("VALUE n 3 1\r\n1\r\nEND", out);
+
+    set.Execute(storage, "abc", out);
+    EXPECT_EQ("CLIENT_ERROR cannot increment or decrement non-numeric value", Counter(storage, "n", 1, false));
+}
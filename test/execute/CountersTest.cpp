@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Counters.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Execute::Counters;
+
+// Parses "STAT <name> <value>" lines of the stats response
+static std::map<std::string, std::string> ParseStats(const std::string &out) {
+    std::map<std::string, std::string> stats;
+    std::istringstream in(out);
+    std::string stat, name, value;
+    while (in >> stat && stat == "STAT" && in >> name >> value) {
+        stats[name] = value;
+    }
+    return stats;
+}
+
+TEST(CountersTest, SumsThreads) {
+    int64_t before[Counters::Count], after[Counters::Count];
+    Counters::Collect(before);
+
+    // Counters of exited threads are kept
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; i++) {
+                Counters::Add(Counters::cmdSet);
+            }
+            Counters::Add(Counters::currConnections);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    Counters::Add(Counters::currConnections, -4);
+
+    Counters::Collect(after);
+    EXPECT_EQ(4000, after[Counters::cmdSet] - before[Counters::cmdSet]);
+    EXPECT_EQ(0, after[Counters::currConnections] - before[Counters::currConnections]);
+}
+
+TEST(CountersTest, StatsCommand) {
+    Backend::SimpleLRU storage(1024);
+    std::string out;
+
+    Execute::Set set("foo", 0, 0);
+    set.Execute(storage, "bar", out);
+    std::vector<std::string_view> keys = {"foo", "baz"};
+    Execute::Get get(keys);
+    get.Execute(storage, "", out);
+
+    Execute::Stats stats;
+    stats.Execute(storage, "", out);
+    ASSERT_EQ(0, out.compare(out.size() - 3, 3, "END"));
+
+    auto values = ParseStats(out);
+    for (const char *name : {"pid", "uptime", "time", "rusage_user", "rusage_system", "curr_connections",
+                             "total_connections", "threads", "limit_maxbytes"}) {
+        EXPECT_EQ(1, values.count(name)) << name;
+    }
+    EXPECT_EQ("1", values["curr_items"]);
+    EXPECT_EQ("0", values["evictions"]);
+    EXPECT_LE(1, std::stoll(values["cmd_set"]));
+    EXPECT_LE(2, std::stoll(values["cmd_get"]));
+    EXPECT_LE(1, std::stoll(values["get_hits"]));
+    EXPECT_LE(1, std::stoll(values["get_misses"]));
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/HotKeys.h>
+#include <afina/execute/Stats.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Execute::HotKeys;
+
+// Returns merged count of the key, 0 if it isn't in the top
+static uint64_t CountOf(const std::string &key) {
+    std::vector<HotKeys::Entry> top;
+    HotKeys::Collect(HotKeys::Capacity, top);
+    for (auto &entry : top) {
+        if (entry.key == key) {
+            return entry.count;
+        }
+    }
+    return 0;
+}
+
+TEST(HotKeysTest, FindsHeavyHitters) {
+    uint32_t sampling = HotKeys::Sampling();
+    HotKeys::SetSampling(1);
+
+    // Two hot keys hidden among many more distinct cold keys than the sketch could hold, in several threads
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 2000; i++) {
+                HotKeys::Record("hot:heavy");
+                if (i % 4 == 0) {
+                    HotKeys::Record("hot:light");
+                }
+                HotKeys::Record("hot:cold:" + std::to_string(t) + ":" + std::to_string(i));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    HotKeys::SetSampling(sampling);
+
+    std::vector<HotKeys::Entry> top;
+    HotKeys::Collect(2, top);
+    ASSERT_EQ(2, top.size());
+    EXPECT_EQ("hot:heavy", top[0].key);
+    EXPECT_EQ("hot:light", top[1].key);
+
+    // Space-saving never underestimates, error bounds overestimation
+    EXPECT_GE(top[0].count, 8000);
+    EXPECT_LE(top[0].count - top[0].error, 8000);
+    EXPECT_GE(top[1].count, 2000);
+    EXPECT_LE(top[1].count - top[1].error, 2000);
+}
+
+TEST(HotKeysTest, Disabled) {
+    uint32_t sampling = HotKeys::Sampling();
+    HotKeys::SetSampling(0);
+    for (int i = 0; i < 1000; i++) {
+        HotKeys::Record("hot:disabled");
+    }
+    HotKeys::SetSampling(sampling);
+
+    EXPECT_EQ(0, CountOf("hot:disabled"));
+}
+
+TEST(HotKeysTest, StatsHotKeys) {
+    Backend::SimpleLRU storage;
+    uint32_t sampling = HotKeys::Sampling();
+    HotKeys::SetSampling(1);
+
+    // Every key of get is an access, even a missing one. Other tests leave plenty of keys in the sketches, so this
+    // one must be accessed often enough to make it to the top
+    Execute::Get get;
+    std::vector<std::string_view> keys = {"hot:stats", "hot:stats"};
+    get.Assign(keys);
+    std::string out;
+    for (int i = 0; i < 5000; i++) {
+        get.Execute(storage, "", out);
+    }
+
+    Execute::Stats stats;
+    std::vector<std::string_view> group = {"hotkeys"};
+    stats.Assign(group);
+    stats.Execute(storage, "", out);
+    HotKeys::SetSampling(sampling);
+
+    EXPECT_NE(std::string::npos, out.find("STAT sampling 1\r\n"));
+
+    // 10000 accesses, but sketch of this thread could have decayed once meanwhile
+    std::size_t pos = out.find("STAT key:hot:stats ");
+    ASSERT_NE(std::string::npos, pos);
+    EXPECT_GE(std::stoull(out.substr(pos + 19)), 5000);
+}
+
+TEST(HotKeysTest, HugeSampling) {
+    // Distance to the next sample is up to twice the sampling, which overflows 32 bits. Fresh thread starts with
+    // the sample, then it mustn't sample again for a long time
+    uint32_t sampling = HotKeys::Sampling();
+    HotKeys::SetSampling(INT32_MAX);
+    std::thread thread([] {
+        for (int i = 0; i < 1000; i++) {
+            HotKeys::Record("hot:huge");
+        }
+    });
+    thread.join();
+    HotKeys::SetSampling(sampling);
+
+    // Sketch could be reused from exited thread, then key inherits count of the one it replaced as an error
+    std::vector<HotKeys::Entry> top;
+    HotKeys::Collect(HotKeys::Capacity, top);
+    auto it = std::find_if(top.begin(), top.end(), [](const HotKeys::Entry &entry) { return entry.key == "hot:huge"; });
+    ASSERT_NE(top.end(), it);
+    EXPECT_EQ(INT32_MAX, it->count - it->error);
+}
+
+TEST(HotKeysTest, StatsEscapesKeys) {
+    Backend::SimpleLRU storage;
+    uint32_t sampling = HotKeys::Sampling();
+    HotKeys::SetSampling(1);
+
+    // Binary protocol allows any bytes in the key, stats line must stay one line
+    std::string key = "hot esc\r\n\x01";
+    for (int i = 0; i < 20000; i++) {
+        HotKeys::Record(key);
+    }
+
+    Execute::Stats stats;
+    std::vector<std::string_view> group = {"hotkeys"};
+    stats.Assign(group);
+    std::string out;
+    stats.Execute(storage, "", out);
+    HotKeys::SetSampling(sampling);
+
+    EXPECT_EQ(std::string::npos, out.find("hot esc"));
+    EXPECT_NE(std::string::npos, out.find("STAT keyhex:686f74206573630d0a01 "));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Latency.h>
+#include <afina/execute/Stats.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Execute::Latency;
+
+TEST(LatencyTest, Buckets) {
+    // Small values are exact, buckets are contiguous and each value falls into the bucket bounding it
+    for (uint64_t v = 0; v < 100000; v++) {
+        std::size_t b = Latency::Bucket(v);
+        ASSERT_LE(v, Latency::BucketLimit(b));
+        ASSERT_TRUE(b == 0 || Latency::BucketLimit(b - 1) < v) << v;
+        ASSERT_LE(Latency::BucketLimit(b) - v, v / 8) << v;
+    }
+    EXPECT_EQ(Latency::Buckets - 1, Latency::Bucket(uint64_t(1) << 50));
+}
+
+TEST(LatencyTest, Percentiles) {
+    Latency::Snapshot before;
+    Latency::Collect(Latency::opDecr, Latency::phWrite, before);
+
+    // 1..1000 ns recorded by several threads
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (uint64_t v = t + 1; v <= 1000; v += 4) {
+                Latency::Record(Latency::opDecr, Latency::phWrite, v);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    Latency::Snapshot snapshot;
+    Latency::Collect(Latency::opDecr, Latency::phWrite, snapshot);
+    ASSERT_EQ(0, before.total);
+    EXPECT_EQ(1000, snapshot.total);
+    EXPECT_EQ(1000, snapshot.max);
+    EXPECT_NEAR(500, snapshot.Percentile(0.5), 500 / 8);
+    EXPECT_NEAR(990, snapshot.Percentile(0.99), 990 / 8);
+    EXPECT_EQ(1000, snapshot.Percentile(1));
+}
+
+TEST(LatencyTest, StatsLatency) {
+    Backend::SimpleLRU storage;
+    Latency::Record(Latency::opIncr, Latency::phStorage, 1500);
+
+    Execute::Stats stats;
+    std::vector<std::string_view> group = {"latency"};
+    stats.Assign(group);
+    std::string out;
+    stats.Execute(storage, "", out);
+    EXPECT_NE(std::string::npos, out.find("STAT incr:storage:count 1\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT incr:storage:p999 1500\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT incr:storage:max 1500\r\n"));
+    EXPECT_EQ(std::string::npos, out.find("decr:parse"));
+
+    group = {"nonsense"};
+    stats.Assign(group);
+    stats.Execute(storage, "", out);
+    EXPECT_EQ("ERROR", out);
+}
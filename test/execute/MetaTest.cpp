@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/MetaArithmetic.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Set.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+
+// Runs meta command built out of the given tokens and returns its response
+template <typename T>
+static std::string Meta(Storage &storage, std::vector<std::string_view> tokens, const std::string &args = "",
+                        std::size_t skip = 1) {
+    T command;
+    command.Assign(tokens, skip);
+    std::string out;
+    command.Execute(storage, args, out);
+    return out;
+}
+
+TEST(MetaTest, GetFlags) {
+    Backend::SimpleLRU storage;
+
+    EXPECT_EQ("EN", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+    EXPECT_EQ("", Meta<Execute::MetaGet>(storage, {"foo", "v", "q"}));
+
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "3", "F7", "T0"}, "bar", 2));
+    EXPECT_EQ("HD", Meta<Execute::MetaGet>(storage, {"foo"}));
+    EXPECT_EQ("HD s3 f7 t-1 Oabc kfoo", Meta<Execute::MetaGet>(storage, {"foo", "s", "f", "t", "Oabc", "k"}));
+    EXPECT_EQ("VA 3 f7\r\nbar", Meta<Execute::MetaGet>(storage, {"foo", "v", "f"}));
+
+    // Text protocol sees the same item
+    std::vector<std::string_view> keys = {"foo"};
+    Execute::Get get(keys);
+    std::string out;
+    get.Execute(storage, "", out);
+    EXPECT_EQ("VALUE foo 7 3\r\nbar\r\nEND", out);
+}
+
+TEST(MetaTest, SetModesAndCas) {
+    Backend::SimpleLRU storage;
+
+    EXPECT_EQ("NS", Meta<Execute::MetaSet>(storage, {"foo", "1", "MR"}, "a", 2));
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "1", "ME"}, "a", 2));
+    EXPECT_EQ("NS", Meta<Execute::MetaSet>(storage, {"foo", "1", "ME"}, "b", 2));
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "1", "MA"}, "c", 2));
+    EXPECT_EQ("", Meta<Execute::MetaSet>(storage, {"foo", "1", "MP", "q"}, "z", 2));
+    EXPECT_EQ("VA 3\r\nzac", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+    EXPECT_EQ("CLIENT_ERROR invalid mode", Meta<Execute::MetaSet>(storage, {"foo", "1", "MX"}, "y", 2));
+    EXPECT_EQ("VA 3\r\nzac", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+
+    std::string hd = Meta<Execute::MetaGet>(storage, {"foo", "c"});
+    ASSERT_EQ(0, hd.find("HD c"));
+    std::string cas = hd.substr(4);
+
+    EXPECT_EQ("EX", Meta<Execute::MetaSet>(storage, {"foo", "1", "C1"}, "x", 2));
+    EXPECT_EQ("NF", Meta<Execute::MetaSet>(storage, {"bar", "1", "C1"}, "x", 2));
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "1", "C" + cas}, "x", 2));
+    EXPECT_EQ("EX", Meta<Execute::MetaDelete>(storage, {"foo", "C" + cas}));
+    EXPECT_EQ("HD kfoo", Meta<Execute::MetaDelete>(storage, {"foo", "k"}));
+    EXPECT_EQ("NF", Meta<Execute::MetaDelete>(storage, {"foo"}));
+}
+
+TEST(MetaTest, StaleWhileRevalidate) {
+    Backend::SimpleLRU storage;
+
+    // Miss with vivify: the first client wins, others see the placeholder
+    EXPECT_EQ("EN", Meta<Execute::MetaGet>(storage, {"foo", "s"}));
+    EXPECT_EQ("HD s0 W", Meta<Execute::MetaGet>(storage, {"foo", "s", "N30"}));
+    EXPECT_EQ("HD s0 Z", Meta<Execute::MetaGet>(storage, {"foo", "s", "N30"}));
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "3", "T60"}, "old", 2));
+    EXPECT_EQ("VA 3\r\nold", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+
+    // Invalidated item is served stale, only one client recaches it
+    EXPECT_EQ("HD", Meta<Execute::MetaDelete>(storage, {"foo", "I"}));
+    EXPECT_EQ("VA 3 W X\r\nold", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+    EXPECT_EQ("VA 3 X Z\r\nold", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+    EXPECT_EQ("HD", Meta<Execute::MetaSet>(storage, {"foo", "3"}, "new", 2));
+    EXPECT_EQ("VA 3\r\nnew", Meta<Execute::MetaGet>(storage, {"foo", "v"}));
+
+    // Item about to expire is recached by a single client as well
+    EXPECT_EQ("HD t60", Meta<Execute::MetaGet>(storage, {"foo", "t", "T60"}));
+    EXPECT_EQ("HD W", Meta<Execute::MetaGet>(storage, {"foo", "R120"}));
+    EXPECT_EQ("HD Z", Meta<Execute::MetaGet>(storage, {"foo", "R120"}));
+}
+
+TEST(MetaTest, Arithmetic) {
+    Backend::SimpleLRU storage;
+
+    EXPECT_EQ("NF", Meta<Execute::MetaArithmetic>(storage, {"cnt"}));
+    EXPECT_EQ("VA 2\r\n10", Meta<Execute::MetaArithmetic>(storage, {"cnt", "N0", "J10", "v"}));
+    EXPECT_EQ("VA 2\r\n15", Meta<Execute::MetaArithmetic>(storage, {"cnt", "D5", "v"}));
+    EXPECT_EQ("HD", Meta<Execute::MetaArithmetic>(storage, {"cnt", "MD", "D3"}));
+    EXPECT_EQ("VA 1\r\n0", Meta<Execute::MetaArithmetic>(storage, {"cnt", "M-", "D100", "v"}));
+    EXPECT_EQ("", Meta<Execute::MetaArithmetic>(storage, {"cnt", "q"}));
+
+    Execute::Set set("str", 0, 0);
+    std::string out;
+    set.Execute(storage, "abc", out);
+    EXPECT_EQ(0, Meta<Execute::MetaArithmetic>(storage, {"str"}).find("CLIENT_ERROR"));
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/NearCache.h>
+#include <afina/execute/Set.h>
+
+#include <storage/ShardedStorage.h>
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Execute::NearCache;
+
+static std::unique_ptr<Storage> MakeShard(std::size_t) { return std::unique_ptr<Storage>(new Backend::SimpleLRU()); }
+
+// Runs set command for the key
+static void SetValue(Storage &storage, const std::string &key, const std::string &value, int32_t expire = 0) {
+    Execute::Set set;
+    set.Assign(key, 7, expire);
+    std::string out;
+    set.Execute(storage, value, out);
+    ASSERT_EQ("STORED", out);
+}
+
+TEST(NearCacheTest, ServesHotKeys) {
+    Backend::ShardedStorage storage(2, MakeShard);
+    NearCache near(16);
+    SetValue(storage, "hot", "v1");
+
+    Execute::Get get;
+    std::vector<std::string_view> keys = {"hot", "none", "hot"};
+    get.Assign(keys, false, &near);
+    std::string out;
+    for (int i = 0; i < 10; i++) {
+        get.Execute(storage, "", out);
+        ASSERT_EQ("VALUE hot 7 2\r\nv1\r\nVALUE hot 7 2\r\nv1\r\nEND", out);
+    }
+    EXPECT_NE(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+    EXPECT_EQ(nullptr, near.Find(storage, "none", Execute::Item::Now()));
+
+    // Write changes key version, so cached response is dropped
+    SetValue(storage, "hot", "v22");
+    EXPECT_EQ(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+    get.Execute(storage, "", out);
+    EXPECT_EQ("VALUE hot 7 3\r\nv22\r\nVALUE hot 7 3\r\nv22\r\nEND", out);
+    EXPECT_NE(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+
+    // gets needs CAS, which isn't cached
+    get.Assign(keys, true, &near);
+    get.Execute(storage, "", out);
+    EXPECT_EQ(0, out.find("VALUE hot 7 3 "));
+}
+
+TEST(NearCacheTest, Expiration) {
+    Backend::ShardedStorage storage(2, MakeShard);
+    NearCache near(16);
+    SetValue(storage, "short", "v", 100);
+
+    Execute::Get get;
+    std::vector<std::string_view> keys = {"short"};
+    get.Assign(keys, false, &near);
+    std::string out;
+    for (int i = 0; i < 10; i++) {
+        get.Execute(storage, "", out);
+    }
+
+    int64_t now = Execute::Item::Now();
+    EXPECT_NE(nullptr, near.Find(storage, "short", now));
+    EXPECT_EQ(nullptr, near.Find(storage, "short", now + 101));
+}
+
+TEST(NearCacheTest, StorageWithoutVersions) {
+    Backend::SimpleLRU storage;
+    NearCache near(16);
+    SetValue(storage, "hot", "v1");
+
+    Execute::Get get;
+    std::vector<std::string_view> keys = {"hot"};
+    get.Assign(keys, false, &near);
+    std::string out;
+    for (int i = 0; i < 10; i++) {
+        get.Execute(storage, "", out);
+        ASSERT_EQ("VALUE hot 7 2\r\nv1\r\nEND", out);
+    }
+    EXPECT_EQ(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+}
+
+TEST(NearCacheTest, Eviction) {
+    Backend::ShardedStorage storage(
+        1, [](std::size_t) { return std::unique_ptr<Storage>(new Backend::SimpleLRU(100)); });
+    NearCache near(16);
+    SetValue(storage, "hot", "v1");
+
+    Execute::Get get;
+    std::vector<std::string_view> keys = {"hot"};
+    get.Assign(keys, false, &near);
+    std::string out;
+    for (int i = 0; i < 10; i++) {
+        get.Execute(storage, "", out);
+    }
+    SetValue(storage, "k1", "v1");
+
+    // Storage is touched by some of the cache hits, so k1 is the least recently used one there
+    for (int i = 0; i < 100; i++) {
+        get.Execute(storage, "", out);
+        ASSERT_EQ("VALUE hot 7 2\r\nv1\r\nEND", out);
+    }
+    SetValue(storage, "k2", "v2");
+    SetValue(storage, "k3", "v3");
+    EXPECT_NE(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+
+    // Evicted key is dropped from the cache
+    SetValue(storage, "k4", "v4");
+    SetValue(storage, "k5", "v5");
+    EXPECT_EQ(nullptr, near.Find(storage, "hot", Execute::Item::Now()));
+    get.Execute(storage, "", out);
+    EXPECT_EQ("END", out);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/Response.h>
+#include <afina/execute/Set.h>
+
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+
+TEST(ResponseTest, Numbers) {
+    Execute::Response response;
+    std::vector<uint64_t> numbers = {0, 7, 10, 99, 100, 12345, std::numeric_limits<uint64_t>::max()};
+    std::string expected;
+    for (auto n : numbers) {
+        response.Append(n).Append(" ");
+        expected += std::to_string(n) + " ";
+    }
+
+    std::string out;
+    response.Flatten(out);
+    EXPECT_EQ(expected, out);
+    EXPECT_EQ(expected.size(), response.Size());
+}
+
+TEST(ResponseTest, ReferencesLargeData) {
+    Execute::Response response;
+    std::string big(1000, 'x');
+    response.Append("VALUE ").Reference(big).Append("\r\n").Reference("small").Append("END");
+
+    // Small data is merged into the text around it
+    std::vector<iovec> iov;
+    response.Iovecs(iov);
+    ASSERT_EQ(3, iov.size());
+    EXPECT_EQ(big.data(), iov[1].iov_base);
+
+    std::string out;
+    response.Flatten(out);
+    EXPECT_EQ("VALUE " + big + "\r\nsmallEND", out);
+
+    // Buffers are kept, but content is gone
+    response.Clear();
+    EXPECT_TRUE(response.Empty());
+    response.Iovecs(iov);
+    EXPECT_TRUE(iov.empty());
+}
+
+TEST(ResponseTest, GetReferencesValues) {
+    Backend::SimpleLRU storage(1024 * 1024);
+    std::string out, big(4096, 'v');
+    Execute::Set("foo", 42, 0).Execute(storage, "bar", out);
+    Execute::Set("big", 1, 0).Execute(storage, big, out);
+
+    std::vector<std::string_view> keys = {"foo", "none", "big"};
+    Execute::Get get(keys);
+    Execute::Response response;
+    get.Execute(storage, "", response);
+
+    std::vector<iovec> iov;
+    response.Iovecs(iov);
+    EXPECT_EQ(3, iov.size());
+
+    response.Flatten(out);
+    EXPECT_EQ("VALUE foo 42 3\r\nbar\r\nVALUE big 1 4096\r\n" + big + "\r\nEND", out);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Trace.h>
+
+using namespace Afina::Execute;
+
+// Drains everything left by previous tests
+static std::vector<Trace::Event> DrainAll(std::size_t &dropped) {
+    std::vector<Trace::Event> events;
+    Trace::Drain([&events](const Trace::Event &e) { events.push_back(e); }, dropped);
+    return events;
+}
+
+TEST(TraceTest, DisabledRecordsNothing) {
+    std::size_t dropped;
+    DrainAll(dropped);
+
+    Trace::Enable(false);
+    Trace::Record(Trace::opSet, "foo", 3);
+    EXPECT_TRUE(DrainAll(dropped).empty());
+}
+
+TEST(TraceTest, EventsOfAllThreads) {
+    std::size_t dropped;
+    DrainAll(dropped);
+
+    Trace::Enable(true);
+    Trace::Record(Trace::opSet, "foo", 3);
+    std::thread t([] {
+        Trace::Record(Trace::opGet, std::string(100, 'k'), 1);
+        Trace::Record(Trace::opAppend, "bar", 5);
+    });
+    t.join();
+    Trace::Enable(false);
+
+    // Ring of the finished thread still gets drained
+    std::vector<Trace::Event> events = DrainAll(dropped);
+    ASSERT_EQ(3, events.size());
+    EXPECT_EQ(0, dropped);
+    EXPECT_EQ(std::string("set"), Trace::Name(events[0].op));
+    EXPECT_EQ("foo", std::string(events[0].key, events[0].key_size));
+    EXPECT_EQ(3, events[0].size);
+    EXPECT_NE(events[0].thread, events[1].thread);
+    EXPECT_EQ(Trace::KeySize, events[1].key_size);
+    EXPECT_EQ(std::string("append"), Trace::Name(events[2].op));
+    EXPECT_LE(events[1].time, events[2].time);
+}
+
+TEST(TraceTest, FullRingDropsEvents) {
+    std::size_t dropped;
+    DrainAll(dropped);
+
+    Trace::Enable(true);
+    for (int i = 0; i < 5000; i++) {
+        Trace::Record(Trace::opGet, "foo", 1);
+    }
+    Trace::Enable(false);
+
+    std::size_t drained = DrainAll(dropped).size();
+    EXPECT_GT(drained, 0);
+    EXPECT_EQ(5000, drained + dropped);
+}
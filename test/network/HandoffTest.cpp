@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/Handoff.h"
+#include "network/mt_blocking/ServerImpl.h"
+#include "network/st_blocking/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+using Network::Handoff;
+
+// Opens TCP socket listening on the loopback at the port kernel chooses
+static int ListenLoopback(uint16_t &port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd == -1 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1 || listen(fd, 16) == -1 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) == -1) {
+        throw std::runtime_error("Failed to listen on loopback");
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// Connects to the loopback port, returns -1 if connection fails
+static int ConnectLoopback(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends request and reads response until it ends with the given suffix
+static std::string Request(uint16_t port, const std::string &request, const std::string &suffix) {
+    int fd = ConnectLoopback(port);
+    if (fd == -1 || send(fd, request.data(), request.size(), 0) != ssize_t(request.size())) {
+        return "";
+    }
+    std::string response;
+    char buffer[1024];
+    ssize_t got;
+    while ((response.size() < suffix.size() || response.compare(response.size() - suffix.size(), suffix.size(),
+                                                                 suffix) != 0) &&
+           (got = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, got);
+    }
+    close(fd);
+    return response;
+}
+
+// Servers need logging, spdlog registers loggers globally so the service is shared by all tests
+static std::shared_ptr<Logging::Service> Logger() {
+    static std::shared_ptr<Logging::Service> service = [] {
+        std::shared_ptr<Logging::Config> config(new Logging::Config);
+        Logging::Appender &console = config->appenders["console"];
+        console.type = Logging::Appender::Type::STDERR;
+        console.color = false;
+        Logging::Logger &root = config->loggers["root"];
+        root.level = Logging::Logger::Level::ERROR;
+        root.appenders.push_back("console");
+        root.format = "[%n] [%l] %v";
+
+        std::shared_ptr<Logging::Service> started(new Logging::ServiceImpl(config));
+        started->Start();
+        return started;
+    }();
+    return service;
+}
+
+TEST(HandoffTest, SocketPair) {
+    uint16_t port;
+    int listener = ListenLoopback(port);
+    int pair[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+
+    ASSERT_TRUE(Handoff::Send(pair[0], {listener}));
+    std::vector<int> sockets;
+    ASSERT_TRUE(Handoff::Receive(pair[1], sockets));
+    ASSERT_EQ(1, sockets.size());
+    EXPECT_NE(listener, sockets[0]);
+
+    // Received descriptor is the same listening socket, so it keeps accepting once the original one is closed
+    close(listener);
+    int client = ConnectLoopback(port);
+    ASSERT_NE(-1, client);
+    int accepted = accept(sockets[0], nullptr, nullptr);
+    EXPECT_NE(-1, accepted);
+    close(accepted);
+    close(client);
+    close(sockets[0]);
+
+    // Nothing but descriptors is a handoff, connection closed without them is reported
+    EXPECT_FALSE(Handoff::Send(pair[0], {}));
+    char tag = 'S';
+    ASSERT_EQ(1, send(pair[0], &tag, 1, 0));
+    EXPECT_FALSE(Handoff::Receive(pair[1], sockets));
+    close(pair[0]);
+    EXPECT_FALSE(Handoff::Receive(pair[1], sockets));
+    EXPECT_TRUE(sockets.empty());
+    close(pair[1]);
+}
+
+TEST(HandoffTest, UnixPath) {
+    std::string path = "/tmp/afina_handoff_test_" + std::to_string(getpid());
+    std::vector<int> sockets;
+
+    // Missing and stale sockets mean there is no running process
+    unlink(path.c_str());
+    EXPECT_EQ(-1, Handoff::Receive(path, sockets));
+    int stale = Handoff::Listen(path);
+    close(stale);
+    EXPECT_EQ(-1, Handoff::Receive(path, sockets));
+
+    // Running process which closes connection without sockets is an error
+    int listener = Handoff::Listen(path);
+    std::thread refuse([listener] { close(accept(listener, nullptr, nullptr)); });
+    EXPECT_THROW(Handoff::Receive(path, sockets), std::runtime_error);
+    refuse.join();
+
+    // Connection stays open until the old process exits, new one waits for that
+    uint16_t port;
+    int tcp = ListenLoopback(port);
+    int old_side = -1;
+    std::thread serve([&] {
+        old_side = accept(listener, nullptr, nullptr);
+        Handoff::Send(old_side, {tcp});
+    });
+    int connection = Handoff::Receive(path, sockets);
+    serve.join();
+    ASSERT_NE(-1, connection);
+    ASSERT_EQ(1, sockets.size());
+
+    auto started = std::chrono::steady_clock::now();
+    std::thread exit([old_side] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        close(old_side);
+    });
+    Handoff::WaitClosed(connection);
+    EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(100));
+    exit.join();
+
+    close(connection);
+    close(sockets[0]);
+    close(tcp);
+    close(listener);
+    unlink(path.c_str());
+}
+
+// Old server stops while the new one accepts on the same socket, stop doesn't wait for a connection to wake it up
+TEST(HandoffTest, BlockingServers) {
+    std::shared_ptr<Afina::Storage> storage(new Backend::ThreadSafeSimplLRU(1 << 20));
+    uint16_t port;
+    int listener = ListenLoopback(port);
+
+    int pair[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+    ASSERT_TRUE(Handoff::Send(pair[0], {listener}));
+    std::vector<int> sockets;
+    ASSERT_TRUE(Handoff::Receive(pair[1], sockets));
+    close(pair[0]);
+    close(pair[1]);
+
+    Network::STblocking::ServerImpl old_server(storage, Logger());
+    old_server.SetListenSocket(listener);
+    old_server.Start(0, 1, 1);
+    EXPECT_EQ(listener, old_server.ListenSocket());
+    EXPECT_EQ("STORED\r\n", Request(port, "set foo 0 0 3\r\nbar\r\n", "\r\n"));
+
+    Network::MTblocking::ServerImpl new_server(storage, Logger());
+    new_server.SetListenSocket(sockets[0]);
+    new_server.Start(0, 1, 4);
+
+    auto started = std::chrono::steady_clock::now();
+    old_server.Stop();
+    old_server.Join();
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(1));
+
+    // Old server has closed its descriptor, the port is still served by the new one
+    EXPECT_EQ("VALUE foo 0 3\r\nbar\r\nEND\r\n", Request(port, "get foo\r\n", "END\r\n"));
+
+    started = std::chrono::steady_clock::now();
+    new_server.Stop();
+    new_server.Join();
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(1));
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <protocol/BinaryParser.h>
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+
+// Builds binary protocol request
+static std::string Request(uint8_t opcode, const std::string &key, const std::string &value = "",
+                           const std::string &extras = "", uint32_t opaque = 0) {
+    std::string r(24, '\0');
+    uint32_t body = extras.size() + key.size() + value.size();
+    r[0] = char(0x80);
+    r[1] = char(opcode);
+    r[2] = char(key.size() >> 8);
+    r[3] = char(key.size());
+    r[4] = char(extras.size());
+    r[8] = char(body >> 24);
+    r[9] = char(body >> 16);
+    r[10] = char(body >> 8);
+    r[11] = char(body);
+    r[12] = char(opaque >> 24);
+    r[13] = char(opaque >> 16);
+    r[14] = char(opaque >> 8);
+    r[15] = char(opaque);
+    return r + extras + key + value;
+}
+
+struct Response {
+    uint8_t opcode;
+    uint16_t status;
+    uint32_t opaque;
+    std::string key;
+    std::string value;
+};
+
+// Parses responses out of output, returns number of them
+static size_t Responses(const std::string &out, std::vector<Response> &responses) {
+    size_t pos = 0;
+    while (pos + 24 <= out.size()) {
+        const uint8_t *h = reinterpret_cast<const uint8_t *>(out.data() + pos);
+        EXPECT_EQ(0x81, h[0]);
+        Response r;
+        r.opcode = h[1];
+        uint16_t key_length = (h[2] << 8) | h[3];
+        uint8_t extras_length = h[4];
+        r.status = (h[6] << 8) | h[7];
+        uint32_t body = (uint32_t(h[8]) << 24) | (h[9] << 16) | (h[10] << 8) | h[11];
+        r.opaque = (uint32_t(h[12]) << 24) | (h[13] << 16) | (h[14] << 8) | h[15];
+        r.key = out.substr(pos + 24 + extras_length, key_length);
+        r.value = out.substr(pos + 24 + extras_length + key_length, body - extras_length - key_length);
+        responses.push_back(r);
+        pos += 24 + body;
+    }
+    EXPECT_EQ(pos, out.size());
+    return responses.size();
+}
+
+TEST(BinaryParserTest, SetGetDelete) {
+    Backend::SimpleLRU storage;
+    Protocol::BinaryParser parser;
+
+    std::string extras(8, '\0');
+    std::string input = Request(0x01, "foo", "fooval", extras, 1) + Request(0x00, "foo", "", "", 2) +
+                        Request(0x0c, "foo", "", "", 3) + Request(0x04, "foo", "", "", 4) +
+                        Request(0x00, "foo", "", "", 5) + Request(0x02, "bar", "v", extras, 6) +
+                        Request(0x02, "bar", "v", extras, 7) + Request(0x0e, "bar", "al", "", 8) +
+                        Request(0x00, "bar", "", "", 9) + Request(0x55, "bar", "", "", 10);
+
+    std::string out;
+    ASSERT_EQ(input.size(), parser.Process(storage, input.data(), input.size(), out));
+    ASSERT_FALSE(parser.Failed());
+
+    std::vector<Response> r;
+    ASSERT_EQ(10, Responses(out, r));
+    for (uint32_t i = 0; i < r.size(); i++) {
+        ASSERT_EQ(i + 1, r[i].opaque);
+    }
+
+    ASSERT_EQ(0, r[0].status);
+    ASSERT_EQ(0, r[1].status);
+    ASSERT_EQ("", r[1].key);
+    ASSERT_EQ("fooval", r[1].value);
+    ASSERT_EQ("foo", r[2].key);
+    ASSERT_EQ("fooval", r[2].value);
+    ASSERT_EQ(0, r[3].status);
+    ASSERT_EQ(1, r[4].status);
+    ASSERT_EQ(0, r[5].status);
+    ASSERT_EQ(2, r[6].status);
+    ASSERT_EQ(0, r[7].status);
+    ASSERT_EQ("val", r[8].value);
+    ASSERT_EQ(0x81, r[9].status);
+}
+
+TEST(BinaryParserTest, DeleteExpired) {
+    Backend::SimpleLRU storage;
+    Protocol::BinaryParser parser;
+
+    // Negative expiration time makes item expired right away
+    std::string expired = std::string(4, '\0') + std::string(4, char(0xff));
+    std::string input = Request(0x01, "old", "v", expired, 1) + Request(0x04, "old", "", "", 2) +
+                        Request(0x01, "new", "v", std::string(8, '\0'), 3) + Request(0x04, "new", "", "", 4) +
+                        Request(0x04, "new", "", "", 5);
+
+    std::string out;
+    ASSERT_EQ(input.size(), parser.Process(storage, input.data(), input.size(), out));
+
+    std::vector<Response> r;
+    ASSERT_EQ(5, Responses(out, r));
+    ASSERT_EQ(0, r[0].status);
+    ASSERT_EQ(1, r[1].status);
+    ASSERT_EQ(0, r[2].status);
+    ASSERT_EQ(0, r[3].status);
+    ASSERT_EQ(1, r[4].status);
+}
+
+TEST(BinaryParserTest, QuietPipeline) {
+    Backend::SimpleLRU storage;
+    Protocol::BinaryParser parser;
+
+    std::string extras(8, '\0');
+    std::string input = Request(0x11, "a", "1", extras) + Request(0x11, "b", "2", extras) +
+                        Request(0x09, "a", "", "", 1) + Request(0x09, "missing", "", "", 2) +
+                        Request(0x0d, "b", "", "", 3) + Request(0x0a, "", "", "", 4);
+
+    // Feed input byte by byte, so that every packet is split
+    std::string out;
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQ(1, parser.Process(storage, input.data() + i, 1, out));
+    }
+
+    std::vector<Response> r;
+    ASSERT_EQ(3, Responses(out, r));
+    ASSERT_EQ(1, r[0].opaque);
+    ASSERT_EQ("1", r[0].value);
+    ASSERT_EQ(3, r[1].opaque);
+    ASSERT_EQ("b", r[1].key);
+    ASSERT_EQ("2", r[1].value);
+    ASSERT_EQ(0x0a, r[2].opcode);
+    ASSERT_EQ(4, r[2].opaque);
+}
+
+TEST(BinaryParserTest, BrokenStream) {
+    Backend::SimpleLRU storage;
+    Protocol::BinaryParser parser;
+
+    std::string input = Request(0x0a, "") + "get foo\r\n" + std::string(20, ' ');
+    std::string out;
+    parser.Process(storage, input.data(), input.size(), out);
+    ASSERT_TRUE(parser.Failed());
+
+    std::vector<Response> r;
+    ASSERT_EQ(1, Responses(out, r));
+}
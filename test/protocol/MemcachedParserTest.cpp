@@ -2,9 +2,15 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Arithmetic.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -21,17 +27,18 @@ TEST(MemcachedParserTest, SimpleSet) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("set foo 0 0 6\r\nfooval\r\n", consumed);
+    std::string input = "set foo 0 0 6\r\nfooval\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(15, consumed);
     ASSERT_EQ("set", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(6, value_size);
 
-    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd);
     ASSERT_EQ("foo", tmp->key());
     ASSERT_EQ(0, tmp->flags());
     ASSERT_EQ(0, tmp->expire());
@@ -42,17 +49,18 @@ TEST(MemcachedParserTest, SimpleAdd) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("add bar 10 -1 60\r\nbarval\r\n", consumed);
+    std::string input = "add bar 10 -1 60\r\nbarval\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(18, consumed);
     ASSERT_EQ("add", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(60, value_size);
 
-    Execute::Add *tmp = reinterpret_cast<Execute::Add *>(cmd.get());
+    Execute::Add *tmp = reinterpret_cast<Execute::Add *>(cmd);
     ASSERT_EQ("bar", tmp->key());
     ASSERT_EQ(10, tmp->flags());
     ASSERT_EQ(-1, tmp->expire());
@@ -63,18 +71,19 @@ TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("get ke key2 super_long_key\r\n", consumed);
+    std::string input = "get ke key2 super_long_key\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(28, consumed);
     ASSERT_EQ("get", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(0, value_size);
 
-    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
-    std::vector<std::string> keys = tmp->keys();
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd);
+    auto &keys = tmp->keys();
     ASSERT_EQ(3, keys.size());
     ASSERT_EQ("ke", keys[0]);
     ASSERT_EQ("key2", keys[1]);
@@ -85,16 +94,303 @@ TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("stats\r\n", consumed);
+    std::string input = "stats\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(7, consumed);
     ASSERT_EQ("stats", parser.Name());
 
     size_t value_size;
-    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Command *cmd = parser.Build(value_size);
     ASSERT_FALSE(cmd == nullptr);
     ASSERT_EQ(0, value_size);
 
-    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
+    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd);
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Verify that line split across reads gives the same command as the whole one
+TEST(MemcachedParserTest, SplitGet) {
+    std::string line = "get";
+    for (int i = 0; i < 20; i++) {
+        line += " some_pretty_long_key_number_" + std::to_string(i);
+    }
+    line += "\r\n";
+
+    for (size_t split = 1; split < line.size(); split++) {
+        Protocol::Parser parser;
+
+        size_t consumed = 0;
+        ASSERT_FALSE(parser.Parse(line.data(), split, consumed));
+        ASSERT_EQ(split, consumed);
+        ASSERT_TRUE(parser.Parse(line.data() + split, line.size() - split, consumed));
+        ASSERT_EQ(line.size() - split, consumed);
+
+        size_t value_size;
+        Execute::Command *cmd = parser.Build(value_size);
+        ASSERT_FALSE(cmd == nullptr);
+
+        Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd);
+        auto &keys = tmp->keys();
+        ASSERT_EQ(20, keys.size());
+        ASSERT_EQ("some_pretty_long_key_number_0", keys[0]);
+        ASSERT_EQ("some_pretty_long_key_number_19", keys[19]);
+    }
+}
+
+// Verify multi digit fields and both parser paths agree on them
+TEST(MemcachedParserTest, SetFields) {
+    std::string line = "set some_key 65535 -3600 1024\r\n";
+    for (size_t split : {line.size(), size_t(10), size_t(20)}) {
+        Protocol::Parser parser;
+
+        size_t consumed = 0;
+        if (split < line.size()) {
+            ASSERT_FALSE(parser.Parse(line.data(), split, consumed));
+        } else {
+            split = 0;
+        }
+        ASSERT_TRUE(parser.Parse(line.data() + split, line.size() - split, consumed));
+        ASSERT_EQ(line.size() - split, consumed);
+
+        size_t value_size;
+        Execute::Command *cmd = parser.Build(value_size);
+        ASSERT_FALSE(cmd == nullptr);
+        ASSERT_EQ(1024, value_size);
+
+        Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd);
+        ASSERT_EQ("some_key", tmp->key());
+        ASSERT_EQ(65535, tmp->flags());
+        ASSERT_EQ(-3600, tmp->expire());
+    }
+}
+
+// Verify that only first command is consumed from the buffer
+TEST(MemcachedParserTest, Pipelined) {
+    Protocol::Parser parser;
+
+    std::string input = "get a b\r\nget c\r\n";
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(9, consumed);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + 9, input.size() - 9, consumed));
+    ASSERT_EQ(7, consumed);
+}
+
+// Verify that unknown command is reported without exception and line is skipped
+TEST(MemcachedParserTest, UnknownCommand) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    std::string input = "unknown foo\r\nget foo\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(13, consumed);
+    ASSERT_EQ("ERROR\r\n", parser.Error());
+
+    size_t value_size;
+    ASSERT_TRUE(parser.Build(value_size) == nullptr);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Error().empty());
+    ASSERT_TRUE(parser.Parse(input.data() + consumed, input.size() - consumed, consumed));
+    ASSERT_EQ(9, consumed);
+    ASSERT_FALSE(parser.Build(value_size) == nullptr);
+}
+
+// Verify that get without keys or with an empty key is rejected as memcached does
+TEST(MemcachedParserTest, GetWithoutKey) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0, value_size;
+    for (std::string input : {"get\r\n", "gets\r\n", "get  k\r\n", "gets k \r\n"}) {
+        parser.Reset();
+        ASSERT_TRUE(parser.Parse(input, consumed));
+        ASSERT_EQ(input.size(), consumed);
+        ASSERT_EQ("ERROR\r\n", parser.Error());
+        ASSERT_TRUE(parser.Build(value_size) == nullptr);
+    }
+
+    parser.Reset();
+    std::string input = "get k\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_TRUE(parser.Error().empty());
+    ASSERT_FALSE(parser.Build(value_size) == nullptr);
+}
+
+// Verify that malformed line split across inputs is skipped up to its end
+TEST(MemcachedParserTest, MalformedSplit) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    std::string input = "set foo 99999999999 0 5\r\n";
+    ASSERT_FALSE(parser.Parse(input.data(), 15, consumed));
+    ASSERT_EQ(15, consumed);
+    ASSERT_TRUE(parser.Parse(input.data() + 15, input.size() - 15, consumed));
+    ASSERT_EQ(input.size() - 15, consumed);
+    ASSERT_EQ("CLIENT_ERROR bad command line format\r\n", parser.Error());
+
+    parser.Reset();
+    input = "mn now\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(input.size(), consumed);
+    ASSERT_EQ("CLIENT_ERROR bad command line format\r\n", parser.Error());
+}
+
+// Verify that complete command isn't copied out of the input
+TEST(MemcachedParserTest, ZeroCopyGet) {
+    Protocol::Parser parser;
+
+    std::string input = "get first_pretty_long_key second_pretty_long_key\r\n";
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+
+    size_t value_size;
+    Execute::Command *cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd);
+    auto &keys = tmp->keys();
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ(input.data() + 4, keys[0].data());
+    ASSERT_EQ("second_pretty_long_key", keys[1]);
+    ASSERT_EQ(input.data(), parser.Name().data());
+}
+
+// Verify that command objects are reused by the next requests
+TEST(MemcachedParserTest, CommandsReused) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0, value_size;
+    std::string input = "set foo 1 0 3\r\nset bar 2 0 5\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    Execute::Command *first = parser.Build(value_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + consumed, input.size() - consumed, consumed));
+    Execute::Command *second = parser.Build(value_size);
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(5, value_size);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(second);
+    ASSERT_EQ("bar", tmp->key());
+    ASSERT_EQ(2, tmp->flags());
+}
+
+// Stats takes optional group of statistics
+TEST(MemcachedParserTest, StatsGroup) {
+    Protocol::Parser parser;
+
+    size_t parsed = 0, body_size = 0;
+    std::string input = "stats latency\r\nstats\r\n";
+    ASSERT_TRUE(parser.Parse(input, parsed));
+    Execute::Stats *stats = dynamic_cast<Execute::Stats *>(parser.Build(body_size));
+    ASSERT_TRUE(stats != nullptr);
+    ASSERT_EQ("latency", stats->group());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + parsed, input.size() - parsed, parsed));
+    ASSERT_EQ(stats, parser.Build(body_size));
+    ASSERT_EQ("", stats->group());
+}
+
+// Meta commands keep key and flags, ms data length is parsed out of its tokens
+TEST(MemcachedParserTest, MetaCommands) {
+    Protocol::Parser parser;
+
+    size_t parsed = 0, body_size = 0;
+    std::string input = "mg foo v s Oabc\r\nms bar 5 T30 F3\r\nhello\r\nmn\r\nms bar x\r\nmg\r\n";
+    ASSERT_TRUE(parser.Parse(input, parsed));
+    ASSERT_EQ("mg", parser.Name());
+    Execute::MetaGet *mg = dynamic_cast<Execute::MetaGet *>(parser.Build(body_size));
+    ASSERT_TRUE(mg != nullptr);
+    ASSERT_EQ("foo", mg->key());
+    ASSERT_EQ(0, body_size);
+
+    size_t pos = parsed;
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + pos, input.size() - pos, parsed));
+    Execute::MetaSet *ms = dynamic_cast<Execute::MetaSet *>(parser.Build(body_size));
+    ASSERT_TRUE(ms != nullptr);
+    ASSERT_EQ("bar", ms->key());
+    ASSERT_EQ(5, body_size);
+
+    pos += parsed + body_size + 2;
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + pos, input.size() - pos, parsed));
+    ASSERT_TRUE(dynamic_cast<Execute::MetaNoop *>(parser.Build(body_size)) != nullptr);
+
+    // Malformed data length and missing key
+    for (int i = 0; i < 2; i++) {
+        pos += parsed;
+        parser.Reset();
+        ASSERT_TRUE(parser.Parse(input.data() + pos, input.size() - pos, parsed));
+        ASSERT_EQ("CLIENT_ERROR bad command line format\r\n", parser.Error());
+        ASSERT_TRUE(parser.Build(body_size) == nullptr);
+    }
+    ASSERT_EQ(input.size(), pos + parsed);
+}
+
+TEST(MemcachedParserTest, DataBlockTerminator) {
+    std::string block = "abc\r\n";
+    ASSERT_TRUE(Protocol::Parser::StripDataBlock(block));
+    ASSERT_EQ("abc", block);
+
+    std::string empty = "\r\n";
+    ASSERT_TRUE(Protocol::Parser::StripDataBlock(empty));
+    ASSERT_EQ("", empty);
+
+    for (std::string bad : {"abcd", "ab\n\n", "ab\r\r", "\n"}) {
+        ASSERT_FALSE(Protocol::Parser::StripDataBlock(bad));
+    }
+    ASSERT_EQ("CLIENT_ERROR bad data chunk\r\n", Protocol::Parser::BadDataChunk);
+}
+
+// CAS unique and incr/decr value are 64-bit, whole line and split line give the same command
+TEST(MemcachedParserTest, CasAndCounters) {
+    Protocol::Parser parser;
+
+    size_t parsed = 0, body_size = 0;
+    std::string input = "cas foo 1 0 3 18446744073709551615\r\n";
+    ASSERT_TRUE(parser.Parse(input, parsed));
+    Execute::Cas *cas = dynamic_cast<Execute::Cas *>(parser.Build(body_size));
+    ASSERT_TRUE(cas != nullptr);
+    ASSERT_EQ("foo", cas->key());
+    ASSERT_EQ(1, cas->flags());
+    ASSERT_EQ(18446744073709551615ull, cas->cas());
+    ASSERT_EQ(3, body_size);
+
+    parser.Reset();
+    ASSERT_FALSE(parser.Parse(input.data(), 12, parsed));
+    ASSERT_TRUE(parser.Parse(input.data() + 12, input.size() - 12, parsed));
+    ASSERT_EQ(cas, parser.Build(body_size));
+    ASSERT_EQ(18446744073709551615ull, cas->cas());
+
+    input = "decr bar 42\r\ngets a b\r\ncas foo 1 0 3\r\nincr bar 18446744073709551616\r\n";
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input, parsed));
+    Execute::Arithmetic *decr = dynamic_cast<Execute::Arithmetic *>(parser.Build(body_size));
+    ASSERT_TRUE(decr != nullptr);
+    ASSERT_EQ("bar", decr->key());
+    ASSERT_EQ(42, decr->delta());
+    ASSERT_TRUE(decr->decrement());
+    ASSERT_EQ(0, body_size);
+
+    size_t pos = parsed;
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + pos, input.size() - pos, parsed));
+    Execute::Get *gets = dynamic_cast<Execute::Get *>(parser.Build(body_size));
+    ASSERT_TRUE(gets != nullptr);
+    ASSERT_TRUE(gets->with_cas());
+
+    // CAS without unique and overflowing value
+    for (int i = 0; i < 2; i++) {
+        pos += parsed;
+        parser.Reset();
+        ASSERT_TRUE(parser.Parse(input.data() + pos, input.size() - pos, parsed));
+        ASSERT_EQ("CLIENT_ERROR bad command line format\r\n", parser.Error());
+        ASSERT_TRUE(parser.Build(body_size) == nullptr);
+    }
+    ASSERT_EQ(input.size(), pos + parsed);
+}
@@ -1,16 +1,35 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
-#include <iostream>
+#include <map>
+#include <random>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <unistd.h>
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/LoadingStorage.h"
+#include "storage/ReadMostlyLRU.h"
+#include "storage/Segment.h"
+#include "storage/SegmentedLRU.h"
+#include "storage/ShardedStorage.h"
+#include "storage/SimpleClock.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/Snapshotter.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TinyLFU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -195,3 +214,929 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, ReadMostlyPromotesOnWrite) {
+    ReadMostlyLRU storage(4 * 8);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    // Buffered promotion of KEY1 must be applied before KEY5 evicts anything
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Get("KEY5", value));
+    EXPECT_TRUE(value == "val5");
+}
+
+TEST(StorageTest, ReadMostlyConcurrent) {
+    const size_t length = 20;
+    ReadMostlyLRU storage(2 * 100 * length);
+
+    for (long i = 0; i < 100; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    std::vector<std::thread> readers;
+    std::atomic<int> misses(0);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &misses, length]() {
+            std::string res;
+            for (long i = 0; i < 10000; ++i) {
+                if (!storage.Get(pad_space("Key " + std::to_string(i % 100), length), res) ||
+                    res != pad_space("Val " + std::to_string(i % 100), length)) {
+                    misses++;
+                }
+            }
+        });
+    }
+
+    // Overwrites with the same value, so readers must always hit
+    for (long i = 0; i < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i % 100), length);
+        auto val = pad_space("Val " + std::to_string(i % 100), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, misses.load());
+}
+
+TEST(StorageTest, ClockPutGetDelete) {
+    SimpleClock storage(4 * 8);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val4"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "val4");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    // Freed slot must be reused
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i % 10), "val1"));
+    }
+    EXPECT_TRUE(storage.Get("KEY9", value));
+}
+
+TEST(StorageTest, ClockSecondChance) {
+    SimpleClock storage(4 * 8);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+TEST(StorageTest, ClockProScanResistance) {
+    SimpleClock plain(10 * 8);
+    SimpleClock pro(10 * 8, true);
+
+    std::string value;
+    for (auto storage : {&plain, &pro}) {
+        for (long i = 0; i < 5; ++i) {
+            EXPECT_TRUE(storage->Put("HOT" + std::to_string(i), "val"));
+            EXPECT_TRUE(storage->Get("HOT" + std::to_string(i), value));
+        }
+
+        // Long sequence of one-time keys
+        for (long i = 0; i < 50; ++i) {
+            EXPECT_TRUE(storage->Put("S" + std::to_string(i + 100), "value"));
+        }
+    }
+
+    for (long i = 0; i < 5; ++i) {
+        EXPECT_FALSE(plain.Get("HOT" + std::to_string(i), value));
+        EXPECT_TRUE(pro.Get("HOT" + std::to_string(i), value));
+    }
+}
+
+TEST(StorageTest, ClockProKeepsUpdatedItemHot) {
+    SimpleClock storage(4 * 8, true);
+
+    std::string value;
+    for (long i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+    }
+
+    // KEY1 is evicted, KEY2..KEY4 get hot
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_TRUE(storage.Get("KEY5", value));
+
+    // Growing KEY2 promotes KEY5 and pushes hot part over its limit, KEY2 itself must not be demoted for that
+    EXPECT_TRUE(storage.Put("KEY2", "val2+"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "val2+");
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    auto hot = std::find_if(stats.begin(), stats.end(), [](const std::pair<std::string, std::string> &s) {
+        return s.first == "hot_items";
+    });
+    ASSERT_TRUE(hot != stats.end());
+    EXPECT_EQ("3", hot->second);
+}
+
+TEST(StorageTest, TinyLFUFrequency) {
+    TinyLFU filter(64);
+
+    for (int i = 0; i < 8; i++) {
+        filter.Record("HOT");
+    }
+    filter.Record("COLD");
+
+    EXPECT_GE(filter.Frequency("HOT"), 8);
+    EXPECT_FALSE(filter.Admit("COLD", "HOT"));
+    EXPECT_TRUE(filter.Admit("HOT", "COLD"));
+
+    // Offering rejected key again doesn't make it any more frequent
+    EXPECT_FALSE(filter.Admit("COLD", "HOT"));
+
+    // Counters are halved periodically, so old popularity fades away
+    for (int i = 0; i < 64 * 10; i++) {
+        filter.Record("OTHER");
+    }
+    EXPECT_LE(filter.Frequency("HOT"), 4);
+}
+
+TEST(StorageTest, TinyLFUScanResistance) {
+    SimpleLRU plain(10 * 8);
+    SimpleLRU filtered(10 * 8, std::make_shared<TinyLFU>(1024));
+
+    std::string value;
+    for (auto storage : {&plain, &filtered}) {
+        for (long i = 0; i < 5; ++i) {
+            EXPECT_TRUE(storage->Put("HOT" + std::to_string(i), "val"));
+        }
+        for (int round = 0; round < 4; ++round) {
+            for (long i = 0; i < 5; ++i) {
+                EXPECT_TRUE(storage->Get("HOT" + std::to_string(i), value));
+            }
+        }
+
+        // Both short and long scans are repeated, so each of their keys is offered twice
+        for (long length : {8, 50}) {
+            for (int pass = 0; pass < 2; ++pass) {
+                for (long i = 0; i < length; ++i) {
+                    storage->Put("S" + std::to_string(length * 100 + i), "val");
+                }
+            }
+        }
+    }
+
+    for (long i = 0; i < 5; ++i) {
+        EXPECT_FALSE(plain.Get("HOT" + std::to_string(i), value));
+        EXPECT_TRUE(filtered.Get("HOT" + std::to_string(i), value));
+    }
+}
+
+// Admits new keys on demand
+class ToggleAdmission : public AdmissionPolicy {
+public:
+    bool admit = false;
+
+    void Record(const std::string &) override {}
+    bool Admit(const std::string &, const std::string &) override { return admit; }
+};
+
+TEST(StorageTest, ClockRejectedKeyKeepsState) {
+    auto admission = std::make_shared<ToggleAdmission>();
+    SimpleClock storage(4 * 8, true, admission);
+
+    std::string value;
+    for (long i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    EXPECT_TRUE(storage.Get("KEY1", value));
+
+    // Rejected key must not promote referenced items or clear their bits
+    EXPECT_FALSE(storage.Put("KEY5", "val5"));
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == "hot_items") {
+            EXPECT_EQ("0", stat.second);
+        }
+    }
+
+    admission->admit = true;
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+TEST(StorageTest, SegmentedRejectedKeyKeepsState) {
+    auto admission = std::make_shared<ToggleAdmission>();
+    SegmentedLRU storage(4 * 8, admission);
+
+    std::string value;
+    for (long i = 1; i <= 4; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    EXPECT_TRUE(storage.Get("KEY1", value));
+
+    // Rejected key must not rescue active cold items or clear their bits
+    EXPECT_FALSE(storage.Put("KEY5", "val5"));
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == "warm_bytes") {
+            EXPECT_EQ("0", stat.second);
+        }
+    }
+
+    admission->admit = true;
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+// Replays look-aside cache trace: Get and Put on miss. Half of the requests goes to the zipf distributed
+// set of popular keys, the rest are keys that never repeat
+double hit_ratio(Afina::Storage &storage, const std::vector<std::string> &trace) {
+    size_t hits = 0;
+    std::string value;
+    for (auto &key : trace) {
+        if (storage.Get(key, value)) {
+            hits++;
+        } else {
+            storage.Put(key, "val");
+        }
+    }
+    return double(hits) / trace.size();
+}
+
+TEST(StorageTest, TinyLFUHitRatio) {
+    const size_t popular = 1000, capacity = 100 * 10, requests = 200000;
+
+    std::vector<double> weights;
+    for (size_t i = 1; i <= popular; i++) {
+        weights.push_back(1.0 / i);
+    }
+
+    std::mt19937 rnd(42);
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    std::vector<std::string> trace;
+    for (size_t i = 0; i < requests; i++) {
+        if (rnd() % 2 == 0) {
+            trace.push_back("HOT" + std::to_string(zipf(rnd)));
+        } else {
+            trace.push_back("ONE" + std::to_string(i));
+        }
+    }
+
+    SimpleLRU lru(capacity);
+    SimpleLRU lru_tinylfu(capacity, std::make_shared<TinyLFU>(100));
+    SimpleClock clock(capacity);
+    SimpleClock clock_tinylfu(capacity, false, std::make_shared<TinyLFU>(100));
+    SimpleClock clock_pro(capacity, true);
+    SimpleClock clock_pro_tinylfu(capacity, true, std::make_shared<TinyLFU>(100));
+
+    double lru_ratio = hit_ratio(lru, trace);
+    double lru_tinylfu_ratio = hit_ratio(lru_tinylfu, trace);
+    double clock_ratio = hit_ratio(clock, trace);
+    double clock_tinylfu_ratio = hit_ratio(clock_tinylfu, trace);
+    double clock_pro_ratio = hit_ratio(clock_pro, trace);
+    double clock_pro_tinylfu_ratio = hit_ratio(clock_pro_tinylfu, trace);
+
+    EXPECT_GT(lru_tinylfu_ratio, lru_ratio);
+    EXPECT_GT(clock_tinylfu_ratio, clock_ratio);
+    EXPECT_GT(clock_pro_tinylfu_ratio, clock_pro_ratio);
+}
+
+TEST(StorageTest, SegmentedPutGetDelete) {
+    SegmentedLRU storage(4 * 8);
+    storage.Start();
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val4"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "val4");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i % 10), "val1"));
+    }
+    EXPECT_TRUE(storage.Get("KEY9", value));
+    storage.Stop();
+}
+
+TEST(StorageTest, SegmentedProtectsActive) {
+    SegmentedLRU storage(10 * 8);
+
+    std::string value;
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+
+    // Second hit moves item to the protected segment
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    storage.Maintain();
+
+    for (long i = 0; i < 50; ++i) {
+        EXPECT_TRUE(storage.Put("S" + std::to_string(i + 100), "value"));
+    }
+
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+TEST(StorageTest, SlabPutGetDelete) {
+    SlabLRU storage(4 * 1024, 1024);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val4"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+    EXPECT_FALSE(storage.Put("BIG", std::string(2048, 'x')));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == "val4");
+
+    // Value moves to another class
+    EXPECT_TRUE(storage.Put("KEY2", std::string(300, 'x')));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(value == std::string(300, 'x'));
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, SlabClassesIsolated) {
+    SlabLRU storage(4 * 1024, 1024);
+
+    std::string value;
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+
+    // Burst of large values evicts only each other
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("BIG" + std::to_string(i), std::string(400, 'x')));
+    }
+
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+    }
+    EXPECT_TRUE(storage.Get("BIG99", value));
+    EXPECT_FALSE(storage.Get("BIG0", value));
+}
+
+TEST(StorageTest, SlabRebalance) {
+    SlabLRU storage(2 * 1024, 1024);
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY", "val"));
+    EXPECT_FALSE(storage.Rebalance());
+
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("BIG" + std::to_string(i), std::string(400, 'x')));
+    }
+
+    // Page of the small values class goes to the class which evicts
+    EXPECT_TRUE(storage.Rebalance());
+    EXPECT_FALSE(storage.Get("KEY", value));
+    EXPECT_FALSE(storage.Rebalance());
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> s(stats.begin(), stats.end());
+    EXPECT_EQ(s["slab_reassign_count"], "1");
+    EXPECT_EQ(s["slab_reassign_last_src"], "0");
+    EXPECT_EQ(s["slab_" + s["slab_reassign_last_dst"] + ":total_pages"], "2");
+
+    // Now there are room for twice more large items
+    for (long i = 0; i < 4; ++i) {
+        EXPECT_TRUE(storage.Put("BIG" + std::to_string(i), std::string(400, 'x')));
+    }
+    for (long i = 0; i < 4; ++i) {
+        EXPECT_TRUE(storage.Get("BIG" + std::to_string(i), value));
+    }
+}
+
+TEST(StorageTest, SlabRebalanceManyClasses) {
+    SlabLRU storage(16 * 4096, 4096);
+
+    auto stats = [&storage]() {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        return std::map<std::string, std::string>(stats.begin(), stats.end());
+    };
+
+    // Three classes get a few pages each, some pages are still free
+    const std::vector<std::pair<std::size_t, long>> classes = {{40, 100}, {300, 30}, {1500, 6}};
+    for (auto &c : classes) {
+        for (long i = 0; i < c.second; ++i) {
+            EXPECT_TRUE(storage.Put(std::to_string(c.first) + "_" + std::to_string(i), std::string(c.first, 'x')));
+        }
+    }
+    auto s = stats();
+    EXPECT_EQ("0", s["evictions"]);
+    EXPECT_NE("0", s["slab_free_pages"]);
+    std::size_t used_classes = 0;
+    for (auto &stat : s) {
+        if (stat.first.find(":total_pages") != std::string::npos && stat.second != "0") {
+            used_classes++;
+        }
+    }
+    EXPECT_EQ(3, used_classes);
+    EXPECT_FALSE(storage.Rebalance());
+
+    // Large values take the rest of the memory and start evicting each other
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("L_" + std::to_string(i), std::string(1500, 'x')));
+    }
+    s = stats();
+    EXPECT_EQ("0", s["slab_free_pages"]);
+
+    // Page moves from one of the classes without evictions to the large one
+    EXPECT_TRUE(storage.Rebalance());
+    s = stats();
+    EXPECT_EQ("1", s["slab_reassign_count"]);
+    std::string src = s["slab_reassign_last_src"], dst = s["slab_reassign_last_dst"];
+    EXPECT_NE(src, dst);
+    EXPECT_GT(std::stoul(s["slab_" + dst + ":evictions"]), 0);
+    EXPECT_EQ("0", s["slab_" + src + ":evictions"]);
+
+    // Moved page took some items of one small class, the other one is untouched
+    std::string value;
+    std::vector<long> lost;
+    for (std::size_t c = 0; c < 2; ++c) {
+        lost.push_back(0);
+        for (long i = 0; i < classes[c].second; ++i) {
+            if (!storage.Get(std::to_string(classes[c].first) + "_" + std::to_string(i), value)) {
+                lost[c]++;
+            }
+        }
+    }
+    EXPECT_TRUE((lost[0] == 0) != (lost[1] == 0));
+    EXPECT_LT(lost[0], classes[0].second);
+    EXPECT_LT(lost[1], classes[1].second);
+
+    // Large class keeps more items now
+    std::size_t chunk_size = std::stoul(s["slab_" + dst + ":chunk_size"]);
+    std::size_t large_chunks = std::stoul(s["slab_" + dst + ":total_pages"]) * (4096 / chunk_size);
+    for (std::size_t i = 0; i < large_chunks; ++i) {
+        EXPECT_TRUE(storage.Put("M_" + std::to_string(i), std::string(1500, 'x')));
+    }
+    for (std::size_t i = 0; i < large_chunks; ++i) {
+        EXPECT_TRUE(storage.Get("M_" + std::to_string(i), value));
+    }
+}
+
+// Items in shared memory segment survive storage, next storage with the same layout attaches to them
+TEST(StorageTest, SlabSharedSegment) {
+    std::string name = "/afina_storage_test_" + std::to_string(getpid());
+    std::string value;
+    {
+        SlabLRU storage(4 * 1024, 1024, nullptr, name);
+        EXPECT_FALSE(storage.Attached());
+        for (long i = 0; i < 10; ++i) {
+            EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        }
+        EXPECT_TRUE(storage.Put("BIG", std::string(400, 'x')));
+        EXPECT_TRUE(storage.Delete("KEY5"));
+
+        // Segment is used by a single storage at once
+        EXPECT_THROW(SlabLRU(4 * 1024, 1024, nullptr, name), std::runtime_error);
+    }
+
+    {
+        SlabLRU storage(4 * 1024, 1024, nullptr, name);
+        EXPECT_TRUE(storage.Attached());
+        for (long i = 0; i < 10; ++i) {
+            EXPECT_EQ(i != 5, storage.Get("KEY" + std::to_string(i), value));
+            if (i != 5) {
+                EXPECT_EQ("val" + std::to_string(i), value);
+            }
+        }
+        EXPECT_TRUE(storage.Get("BIG", value));
+        EXPECT_EQ(std::string(400, 'x'), value);
+        EXPECT_TRUE(storage.Put("KEY5", "val5"));
+
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        std::map<std::string, std::string> s(stats.begin(), stats.end());
+        EXPECT_EQ("11", s["curr_items"]);
+        EXPECT_EQ("1", s["slab_segment_attached"]);
+    }
+
+    // Different layout starts from scratch
+    {
+        SlabLRU storage(8 * 1024, 1024, nullptr, name);
+        EXPECT_FALSE(storage.Attached());
+        EXPECT_FALSE(storage.Get("KEY1", value));
+    }
+    EXPECT_TRUE(Segment::Unlink(name));
+}
+
+// MultiGet returns values in the request order whatever shards keys are stored in
+TEST(StorageTest, ShardedMultiGet) {
+    ShardedStorage storage(4, [](std::size_t) { return std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU()); });
+
+    std::vector<std::string_view> keys;
+    std::vector<std::string> names;
+    for (int i = 0; i < 32; i++) {
+        names.push_back("KEY" + std::to_string(i));
+    }
+    for (int i = 0; i < 32; i += 2) {
+        EXPECT_TRUE(storage.Put(names[i], "val" + std::to_string(i)));
+    }
+    for (int i = 31; i >= 0; i--) {
+        keys.push_back(names[i]);
+    }
+
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    for (int round = 0; round < 2; round++) {
+        storage.MultiGet(keys, values, found);
+        ASSERT_EQ(keys.size(), values.size());
+        ASSERT_EQ(keys.size(), found.size());
+        for (int i = 0; i < 32; i++) {
+            int n = 31 - i;
+            EXPECT_EQ(n % 2 == 0, found[i]) << n;
+            if (found[i]) {
+                EXPECT_EQ("val" + std::to_string(n), values[i]);
+            }
+        }
+    }
+
+    // Backends with own MultiGet agree with the default one
+    SlabLRU slab(4 * 1024, 1024);
+    SegmentedLRU segmented(4 * 1024);
+    for (Afina::Storage *s : std::vector<Afina::Storage *>{&slab, &segmented}) {
+        EXPECT_TRUE(s->Put("KEY1", "val1"));
+        s->MultiGet({"KEY0", "KEY1", "KEY1"}, values, found);
+        EXPECT_EQ(std::vector<bool>({false, true, true}), found);
+        EXPECT_EQ("val1", values[1]);
+        EXPECT_EQ("val1", values[2]);
+    }
+}
+
+// Hot key is read from the replica until it is written
+TEST(StorageTest, ShardedHotKeys) {
+    ShardedStorage storage(
+        4, [](std::size_t) { return std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU()); }, 16);
+
+    auto replica_hits = [&storage]() {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.Stats(stats);
+        for (auto &stat : stats) {
+            if (stat.first == "hot_replica_hits") {
+                return std::stoull(stat.second);
+            }
+        }
+        return 0ull;
+    };
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("HOT", "val1"));
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Get("HOT", value));
+        EXPECT_EQ("val1", value);
+    }
+    EXPECT_GT(replica_hits(), 80);
+
+    // Every kind of write invalidates replica
+    EXPECT_TRUE(storage.Put("HOT", "val2"));
+    EXPECT_TRUE(storage.Get("HOT", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_TRUE(storage.Append("HOT", "+", [](std::string &) { return true; }));
+    EXPECT_TRUE(storage.Get("HOT", value));
+    EXPECT_EQ("val2+", value);
+
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    storage.MultiGet({"HOT", "COLD", "HOT"}, values, found);
+    EXPECT_EQ(std::vector<bool>({true, false, true}), found);
+    EXPECT_EQ("val2+", values[2]);
+
+    EXPECT_TRUE(storage.Delete("HOT"));
+    EXPECT_FALSE(storage.Get("HOT", value));
+    storage.MultiGet({"HOT"}, values, found);
+    EXPECT_FALSE(found[0]);
+
+    // Readers never see value older than one they have already seen while writer keeps increasing it
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    std::atomic<int> errors(0);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&] {
+            long last = 0;
+            std::string current;
+            while (!done.load()) {
+                if (storage.Get("HOT", current)) {
+                    long seen = std::stol(current);
+                    if (seen < last) {
+                        errors++;
+                    }
+                    last = seen;
+                }
+            }
+        });
+    }
+    for (long i = 1; i <= 20000; i++) {
+        storage.Put("HOT", std::to_string(i));
+    }
+    done = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+    EXPECT_TRUE(storage.Get("HOT", value));
+    EXPECT_EQ("20000", value);
+}
+
+// Replica of the evicted key isn't served, replica hits keep the key recently used in its shard
+TEST(StorageTest, ShardedHotKeysEviction) {
+    ShardedStorage storage(
+        1, [](std::size_t) { return std::unique_ptr<Afina::Storage>(new SimpleLRU(40)); }, 4);
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("HOT", "val1"));
+    for (int i = 0; i < 20; i++) {
+        EXPECT_TRUE(storage.Get("HOT", value));
+    }
+    EXPECT_TRUE(storage.Put("K1", "value1"));
+
+    // Shard sees some of these reads, so K1 is the least recently used one there
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Get("HOT", value));
+    }
+    for (int i = 2; i <= 5; i++) {
+        EXPECT_TRUE(storage.Put("K" + std::to_string(i), "value" + std::to_string(i)));
+    }
+    EXPECT_FALSE(storage.Get("K1", value));
+    EXPECT_TRUE(storage.Get("HOT", value));
+    EXPECT_EQ("val1", value);
+
+    // Once the shard evicts the key its replica is gone too
+    for (int i = 6; i <= 10; i++) {
+        EXPECT_TRUE(storage.Put("K" + std::to_string(i), "value" + std::to_string(i)));
+    }
+    EXPECT_FALSE(storage.Get("HOT", value));
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    storage.MultiGet({"HOT"}, values, found);
+    EXPECT_FALSE(found[0]);
+}
+
+TEST(StorageTest, ConditionalWrites) {
+    SimpleLRU lru(1024);
+    ReadMostlyLRU read_mostly(1024);
+    SimpleClock clock(1024);
+    SegmentedLRU segmented(1024);
+    SlabLRU slab(4 * 1024, 1024);
+    ShardedStorage sharded(2, [](std::size_t) { return std::unique_ptr<Afina::Storage>(new SimpleClock(1024)); });
+
+    // Value starting with '-' counts as absent, patch marks value it has seen with '+'
+    auto present = [](const std::string &current) { return current.empty() || current[0] != '-'; };
+    auto patch = [](std::string &current) {
+        if (current.empty() || current[0] == '-') {
+            return false;
+        }
+        current[0] = '+';
+        return true;
+    };
+
+    std::vector<Afina::Storage *> all = {&lru, &read_mostly, &clock, &segmented, &slab, &sharded};
+    for (Afina::Storage *s : all) {
+        std::string value;
+        EXPECT_FALSE(s->Replace("KEY", "#1", present));
+        EXPECT_FALSE(s->Append("KEY", "x", patch));
+        EXPECT_FALSE(s->Get("KEY", value));
+
+        EXPECT_TRUE(s->Add("KEY", "#1", present));
+        EXPECT_FALSE(s->Add("KEY", "#2", present));
+        EXPECT_TRUE(s->Replace("KEY", "#3", present));
+        EXPECT_TRUE(s->Append("KEY", "ab", patch));
+        EXPECT_TRUE(s->Insert("KEY", "cd", 1, patch));
+        EXPECT_TRUE(s->Get("KEY", value));
+        EXPECT_EQ("+cd3ab", value);
+        EXPECT_TRUE(s->Prepend("KEY", "z", patch));
+        EXPECT_TRUE(s->Get("KEY", value));
+        EXPECT_EQ("z+cd3ab", value);
+
+        // Absent value is overwritten by add and is never patched
+        EXPECT_TRUE(s->Put("KEY", "-1"));
+        EXPECT_FALSE(s->Replace("KEY", "#4", present));
+        EXPECT_FALSE(s->Prepend("KEY", "x", patch));
+        EXPECT_TRUE(s->Get("KEY", value));
+        EXPECT_EQ("-1", value);
+        EXPECT_TRUE(s->Add("KEY", "#5", present));
+        EXPECT_TRUE(s->Get("KEY", value));
+        EXPECT_EQ("#5", value);
+
+        // Value never grows over storage size
+        EXPECT_FALSE(s->Append("KEY", std::string(2048, 'x'), patch));
+        EXPECT_TRUE(s->Get("KEY", value));
+        EXPECT_EQ("#5", value);
+    }
+}
+
+// Returns all items of the storage in the order Scan passes them
+static std::vector<std::pair<std::string, std::string>> ScanAll(Afina::Storage &storage) {
+    std::vector<std::pair<std::string, std::string>> items;
+    EXPECT_TRUE(storage.Scan([&items](std::string_view key, std::string_view value) {
+        items.emplace_back(std::string(key), std::string(value));
+    }));
+    return items;
+}
+
+// Snapshot keeps every item, least recently used first, and loading restores the order
+TEST(StorageTest, SnapshotWriteLoad) {
+    std::string path = "afina_snapshot_test_" + std::to_string(getpid());
+    std::size_t written, loaded;
+
+    SimpleLRU lru;
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(lru.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    std::string value;
+    EXPECT_TRUE(lru.Get("KEY0", value));
+
+    ASSERT_TRUE(Snapshot::Write(lru, path, written));
+    EXPECT_EQ(8, written);
+    SimpleLRU lru_loaded;
+    ASSERT_TRUE(Snapshot::Load(lru_loaded, path, 4, loaded));
+    EXPECT_EQ(8, loaded);
+    auto items = ScanAll(lru_loaded);
+    ASSERT_EQ(8, items.size());
+    for (int i = 1; i < 8; i++) {
+        EXPECT_EQ("KEY" + std::to_string(i), items[i - 1].first);
+        EXPECT_EQ("val" + std::to_string(i), items[i - 1].second);
+    }
+    EXPECT_EQ("KEY0", items[7].first);
+
+    // Every storage that can be scanned passes all of its items
+    SimpleClock clock;
+    SegmentedLRU segmented(4 * 1024);
+    SlabLRU slab(4 * 1024, 1024);
+    for (Afina::Storage *s : std::vector<Afina::Storage *>{&clock, &segmented, &slab}) {
+        for (int i = 0; i < 8; i++) {
+            EXPECT_TRUE(s->Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        }
+        ASSERT_TRUE(Snapshot::Write(*s, path, written));
+        EXPECT_EQ(8, written);
+
+        SimpleLRU target;
+        ASSERT_TRUE(Snapshot::Load(target, path, 2, loaded));
+        EXPECT_EQ(8, loaded);
+        for (int i = 0; i < 8; i++) {
+            EXPECT_TRUE(target.Get("KEY" + std::to_string(i), value));
+            EXPECT_EQ("val" + std::to_string(i), value);
+        }
+    }
+
+    // Forked child writes the same while parent may keep changing storage
+    Snapshotter snapshotter(std::shared_ptr<Afina::Storage>(&lru, [](Afina::Storage *) {}), path,
+                            std::chrono::seconds(0));
+    EXPECT_TRUE(lru.Put("KEY8", "val8"));
+    ASSERT_TRUE(snapshotter.Take());
+    SimpleLRU forked;
+    ASSERT_TRUE(Snapshot::Load(forked, path, 1, loaded));
+    items = ScanAll(forked);
+    ASSERT_EQ(9, items.size());
+    EXPECT_EQ("KEY8", items[8].first);
+
+    std::remove(path.c_str());
+}
+
+// Shards of big snapshot are filled in parallel, each of them in the snapshot order
+TEST(StorageTest, SnapshotParallelLoad) {
+    std::string path = "afina_snapshot_test_" + std::to_string(getpid());
+    auto factory = [](std::size_t) { return std::unique_ptr<Afina::Storage>(new ThreadSafeSimplLRU(4 << 20)); };
+    ShardedStorage source(8, factory);
+
+    // Several chunks worth of items, some of them are read to change recency order
+    std::string big(1024, 'x');
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_TRUE(source.Put("KEY" + std::to_string(i), big + std::to_string(i)));
+    }
+    std::string value;
+    for (int i = 0; i < 10000; i += 7) {
+        EXPECT_TRUE(source.Get("KEY" + std::to_string(i), value));
+    }
+
+    std::size_t written, loaded;
+    ASSERT_TRUE(Snapshot::Write(source, path, written));
+    EXPECT_EQ(10000, written);
+
+    ShardedStorage target(8, factory);
+    EXPECT_TRUE(target.Put("KEY1", "newer"));
+    std::atomic<std::size_t> reported(0);
+    ASSERT_TRUE(Snapshot::Load(target, path, 4, loaded, [&reported](std::size_t loaded, std::size_t total) {
+        EXPECT_EQ(10000, total);
+        reported = std::max<std::size_t>(reported, loaded);
+        return true;
+    }));
+    EXPECT_EQ(9999, loaded);
+    EXPECT_EQ(10000, reported);
+
+    // Value written before load wins, everything else is in the same order
+    EXPECT_TRUE(target.Get("KEY1", value));
+    EXPECT_EQ("newer", value);
+    auto expected = ScanAll(source), actual = ScanAll(target);
+    auto is_key1 = [](const std::pair<std::string, std::string> &item) { return item.first == "KEY1"; };
+    expected.erase(std::remove_if(expected.begin(), expected.end(), is_key1), expected.end());
+    actual.erase(std::remove_if(actual.begin(), actual.end(), is_key1), actual.end());
+    EXPECT_TRUE(expected == actual);
+
+    // Progress callback could stop loading
+    ShardedStorage stopped(8, factory);
+    EXPECT_FALSE(Snapshot::Load(stopped, path, 1, loaded, [](std::size_t, std::size_t) { return false; }));
+
+    // Missing file is an empty snapshot, truncated one is rejected
+    std::remove(path.c_str());
+    EXPECT_TRUE(Snapshot::Load(stopped, path, 4, loaded));
+    EXPECT_EQ(0, loaded);
+
+    std::ofstream(path, std::ios::binary) << "AFNSNAP1" << std::string(100, '\0');
+    EXPECT_FALSE(Snapshot::Load(stopped, path, 4, loaded));
+    std::remove(path.c_str());
+}
+
+// Clients served during partial load delete and write keys which loader hasn't reached yet
+TEST(StorageTest, SnapshotLoadWhileServing) {
+    std::string path = "afina_snapshot_test_" + std::to_string(getpid());
+    ThreadSafeSimplLRU source(1 << 20);
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_TRUE(source.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    std::size_t written, loaded;
+    ASSERT_TRUE(Snapshot::Write(source, path, written));
+
+    LoadingStorage target(std::make_shared<ThreadSafeSimplLRU>(1 << 20));
+    bool served = false;
+    ASSERT_TRUE(Snapshot::Load(target, path, 1, loaded, [&](std::size_t loaded, std::size_t) {
+        if (!served) {
+            served = true;
+            EXPECT_LT(loaded, 9000);
+            EXPECT_FALSE(target.Delete("KEY9000"));
+            EXPECT_TRUE(target.Put("KEY9500", "client"));
+            EXPECT_TRUE(target.Put("KEY9600", "client"));
+            EXPECT_TRUE(target.Delete("KEY9600"));
+        }
+        return true;
+    }));
+    target.Loaded();
+    std::remove(path.c_str());
+    EXPECT_EQ(9997, loaded);
+
+    std::string value;
+    EXPECT_FALSE(target.Get("KEY9000", value));
+    EXPECT_FALSE(target.Get("KEY9600", value));
+    EXPECT_TRUE(target.Get("KEY9500", value));
+    EXPECT_EQ("client", value);
+    EXPECT_TRUE(target.Get("KEY9999", value));
+    EXPECT_EQ("val9999", value);
+
+    // Once loaded, keys are stored if absent as usual
+    EXPECT_TRUE(target.PutIfAbsent("KEY9000", "again"));
+    EXPECT_FALSE(target.PutIfAbsent("KEY9500", "again"));
+}